@@ -0,0 +1,88 @@
+//! \copyright Mozilla Public License Version 2.0
+//! \note [License]		 license/license.txt
+//! \note [Contributors] license/contributors.txt
+
+#pragma once
+
+// C++ STD
+#include <cstddef>
+#include <type_traits>
+
+// ssa
+#include "ssa_platform.hpp"
+#include "ssa_memory.hpp"
+
+namespace ssa
+{
+	//! \brief Source of raw memory for the engine's pools. Pools take an Allocator at construction and
+	//!		request big blocks from it ( pages, tables, arrays ), never single objects. The allocator must
+	//!		outlive every pool using it
+	class ssa_export Allocator
+	{
+	public:
+		virtual ~Allocator() { }
+
+		//! \brief Allocates p_size bytes aligned to p_alignment ( power of two )
+		//! \return Pointer to the memory, nullptr if allocation failed
+		virtual void* allocate(std::size_t p_size, std::size_t p_alignment) = 0;
+
+		//! \brief Releases memory returned by allocate(), p_size is the size it was requested with
+		virtual void deallocate(void* p_memory, std::size_t p_size) = 0;
+	};
+
+	//! \brief Allocator on the process heap ( aligned_malloc / aligned_free ), used when none is specified
+	class ssa_export HeapAllocator : public Allocator
+	{
+	public:
+		void* allocate(std::size_t p_size, std::size_t p_alignment) override { return aligned_malloc(p_size, p_alignment); }
+		void deallocate(void* p_memory, std::size_t) override { aligned_free(p_memory); }
+	};
+
+	//! \brief Returns the HeapAllocator shared by all the pools constructed without an explicit allocator
+	ssa_export Allocator& get_default_allocator();
+
+	//! \brief STL-compatible adapter, lets containers draw their memory from an Allocator
+	template <typename object_t>
+	class StlAllocator
+	{
+	public:
+		typedef object_t value_type;
+
+		template <typename other_t>
+		struct rebind
+		{
+			typedef StlAllocator<other_t> other;
+		};
+
+	public:
+		StlAllocator() : m_allocator{ &get_default_allocator() } { }
+		explicit StlAllocator(Allocator& p_allocator) : m_allocator{ &p_allocator } { }
+
+		template <typename other_t>
+		StlAllocator(const StlAllocator<other_t>& p_other) : m_allocator{ &p_other.get_allocator() } { }
+
+		object_t* allocate(std::size_t p_count) 
+		{ 
+			return static_cast<object_t*>(m_allocator->allocate(sizeof(object_t) * p_count, std::alignment_of<object_t>::value));
+		}
+
+		void deallocate(object_t* p_memory, std::size_t p_count) { m_allocator->deallocate(p_memory, sizeof(object_t) * p_count); }
+
+		Allocator& get_allocator()const { return *m_allocator; }
+
+	private:
+		Allocator* m_allocator;
+	};
+
+	template <typename first_t, typename second_t>
+	bool operator==(const StlAllocator<first_t>& p_first, const StlAllocator<second_t>& p_second)
+	{
+		return &p_first.get_allocator() == &p_second.get_allocator();
+	}
+
+	template <typename first_t, typename second_t>
+	bool operator!=(const StlAllocator<first_t>& p_first, const StlAllocator<second_t>& p_second)
+	{
+		return !(p_first == p_second);
+	}
+}
\ No newline at end of file
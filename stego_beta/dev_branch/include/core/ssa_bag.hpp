@@ -7,77 +7,308 @@
 // C++ STD
 #include <cstdlib>
 #include <cstdint>
-#include <list>
+#include <cstring>
+#include <vector>
+#include <algorithm>
+#include <functional>
+#include <utility>
+#include <new>
+#include <atomic>
+#include <mutex>
 #include <cassert>
+#include <istream>
+#include <ostream>
 
 // ssa
 #include "../core/ssa_platform.hpp"
+#include "../core/ssa_bits.hpp"
+#include "../core/ssa_memory.hpp"
+#include "../core/ssa_allocator.hpp"
+#include "../core/ssa_pool_stats.hpp"
 
 namespace ssa
 {
-
+	//! \brief Pool of fixed-size elements, memory is allocated in pages of elements and grows on demand.
+	//!		Pages are never moved or released while the Bag is alive, pointers to elements stay valid
+	//!		till the element is recycled or till compact() is explicitly called
+	//!
+	//! Live elements are tracked in an occupancy bitmap ( one bit per slot ), iteration skips empty
+	//!	words without touching the elements' memory. Free slots are linked through their own memory.
+	//!
+	//! Pages are allocated on the Bag's alignment and the stride between elements is the element size 
+	//!	rounded up to that alignment, every element starts on an aligned address
+	//!
+	//! In concurrent mode add_object() and recycle() can be called from multiple threads at the same time: 
+	//!	the free list is a lock-free tagged stack, occupancy bits are set atomically and new pages are 
+	//!	published atomically ( only the thread that grows takes a lock ). Iteration and compact() still 
+	//!	require exclusive access
+	//!
+	//! All the memory ( pages, occupancy bits and page tables ) comes from the Allocator passed at construction,
+	//!	every page and its occupancy bits are a single allocation
 	class ssa_export Bag
 	{
 	public:
 		typedef std::uint64_t index_t;
 
+		//! \brief Number of elements per page if not specified otherwise
+		static const std::size_t default_page_size{ 256 };
+
+		//! \brief Index returned when there is no element
+		static const index_t npos{ ~static_cast<index_t>(0) };
+
+		//! \brief Describes the cost of a single grow, reported to the grow callback
+		struct GrowEvent
+		{
+			std::size_t		pages;			// Number of pages allocated
+			std::size_t		bytes;			// Number of bytes allocated
+			index_t			old_capacity;	// Capacity ( in elements ) before growing
+			index_t			new_capacity;	// Capacity ( in elements ) after growing
+			std::uint64_t	microseconds;	// Time spent allocating and initializing the pages
+		};
+
+		typedef std::function<void(const GrowEvent&)> grow_callback_t;
+
+		//! \brief Element moved by compact() from one spot to another
+		struct Relocation
+		{
+			index_t from;
+			index_t to;
+		};
+
+		typedef std::vector<Relocation> remap_t;
+
+		//! \brief Addresses the pages had when a snapshot was written, translates pointers to elements stored
+		//!		inside the snapshot ( or inside other snapshots ) to the indices of the elements
+		struct SnapshotLayout
+		{
+			// Base address of every page and index of its first element, sorted by address
+			std::vector<std::pair<std::uint64_t, index_t>>	pages;
+			std::size_t										page_size;		// Elements per page
+			std::size_t										element_size;	// Stride
+
+			//! \brief Returns the index of the element p_address pointed to when the snapshot was written, npos if none
+			index_t find(const void* p_address)const;
+		};
+
+		//! \brief Type-erased lifetime operations, left null for raw byte bags where elements are simply
+		//!		zeroed when recycled and copied bitwise when moved
+		struct ObjectTraits
+		{
+			// Destroys the object in place
+			void(*destroy)(void* p_object);
+
+			// Move-constructs an object in p_destination from p_source and destroys p_source
+			void(*relocate)(void* p_destination, void* p_source);
+		};
+
 	public:
-		//! Constructs a new instance of Bag and allocates the initial buffer
-		//! \param p_element_size
-		//! \param p_initial_buffer_size
-		Bag(std::size_t p_element_size, std::size_t p_initial_buffer_size);
+		//! \brief Constructs a new instance of Bag and allocates enough pages for the initial capacity
+		//! \param [in] p_element_size Size in bytes of a single element
+		//! \param [in] p_initial_capacity Number of elements the Bag can hold before the first grow
+		//! \param [in] p_page_size Number of elements per page, rounded up to the next power of two
+		//! \param [in] p_alignment Alignment of the elements ( power of two ), 64 places every element on its own cache line(s).
+		//!		natural_alignment packs the elements without padding ( see get_natural_alignment() )
+		//! \param [in] p_allocator Source of all the Bag's memory, must outlive the Bag
+		Bag(std::size_t p_element_size, std::size_t p_initial_capacity, std::size_t p_page_size = default_page_size, 
+			std::size_t p_alignment = natural_alignment, Allocator& p_allocator = get_default_allocator());
 
-		//! Deallocates all internal memory
+		//! \brief Destroys all the live elements and deallocates all internal memory
 		~Bag();
 
+		//! \brief Enables / disables concurrent allocation, must be called while no other thread is using the Bag
+		void set_concurrent(bool p_concurrent) { m_concurrent = p_concurrent; }
+		bool is_concurrent()const { return m_concurrent; }
+
+		Bag(const Bag&) = delete;
+		Bag& operator=(const Bag&) = delete;
+
+		//! \brief Constructs a new object in place in the first free spot
+		//! \param [in] p_args Constructor arguments, perfectly forwarded
+		//! \return Index of the new object
 		template <typename object_t, typename ...ctor_args>
-		index_t add_object(ctor_args ...p_args);
+		index_t add_object(ctor_args&& ...p_args);
 
 		template <typename object_t>
 		object_t& get_object(index_t p_index);
 
+		//! \brief Destroys the object ( if the Bag has ObjectTraits ) and marks its spot as free
 		void recycle(index_t p_index);
 
-		uint8_t* get_data_ptr()					{ return m_data; }
+		//! \brief Allocates the pages needed to add p_count more elements without growing
+		void reserve(std::size_t p_count);
+
+		//! \brief Moves all the live elements to the front of the Bag and releases the pages left empty.
+		//!		Every pointer to a moved element is invalidated, owners should patch them using the returned table
+		//! \return List of the elements that have been moved, elements not in the list kept their index
+		remap_t compact();
+
+		//! \brief True if the elements can be moved with memcpy, either a raw byte bag or a TypedBag of a trivially copyable type
+		bool is_trivially_copyable()const { return m_traits.destroy == nullptr && m_traits.relocate == nullptr; }
+
+		//! \brief Writes the whole Bag ( pages, occupancy bits and free list ) to the stream as raw bytes, the Bag must be
+		//!		trivially copyable. Pointers stored inside the elements are written as they are, see SnapshotLayout
+		//! \return False if the Bag is not trivially copyable or writing failed
+		bool write_snapshot(std::ostream& p_stream)const;
+
+		//! \brief Replaces the content of the Bag with a snapshot written by write_snapshot(), element size, alignment and
+		//!		page size must match. Elements keep their indices, the free list is restored as it was
+		//! \param [out] p_layout If not null, filled with the page addresses at the time of the snapshot
+		//! \return False if the snapshot is not compatible, truncated or corrupt, the Bag is left empty if reading failed halfway
+		bool read_snapshot(std::istream& p_stream, SnapshotLayout* p_layout = nullptr);
+
+		//! \brief Returns the address of the element at the specified index, elements are contiguous only inside a page
+		uint8_t* get_element_ptr(index_t p_index)const
+		{
+			assert(p_index < get_capacity());
+			return m_pages.load(std::memory_order_acquire)[static_cast<std::size_t>(p_index >> m_page_shift)].data + 
+				static_cast<std::size_t>(p_index & m_page_mask) * m_element_size;
+		}
+
+		//! \brief True if the slot at the specified index holds a live element
+		bool is_occupied(index_t p_index)const
+		{
+			return p_index < get_capacity() && (_occupancy_word(p_index).load(std::memory_order_relaxed) & _occupancy_bit(p_index)) != 0;
+		}
+
+		//! \brief Returns the index of the first live element at or after p_index, npos if there are none
+		index_t next_object(index_t p_index)const;
+
+		//! \brief Calls p_func(index_t) for every live element in ascending order, empty 64-slot words are skipped
+		//!		with a single test. Recycling the current element from inside p_func is allowed
+		template <typename func_t>
+		void for_each(func_t p_func)const;
+
+		//! \brief Returns the stride between two elements, element size rounded up to the alignment
 		std::size_t get_element_size()const		{ return m_element_size; }
-		index_t get_last_element_pos()const 
-		{ 
-			return m_current_size; 
+		std::size_t get_alignment()const		{ return m_alignment; }
+		Allocator& get_allocator()const			{ return *m_allocator; }
+		std::size_t get_page_size()const		{ return m_page_mask + 1; }
+		std::size_t get_page_count()const		{ return m_page_count.load(std::memory_order_acquire); }
+		index_t get_capacity()const				{ return m_capacity.load(std::memory_order_acquire); }
+		index_t get_size()const					{ return m_size.load(std::memory_order_relaxed); }
+		index_t get_last_element_pos()const
+		{
+			return get_capacity();
 		}
 
+		//! \brief Sets the callback invoked every time the Bag allocates new pages
+		void set_grow_callback(const grow_callback_t& p_callback) { m_grow_callback = p_callback; }
+
+		//! \brief Returns the informations about the last grow, zeroed if the Bag never grew
+		const GrowEvent& get_last_grow()const { return m_last_grow; }
+
+		//! \brief Returns occupancy and memory usage of the Bag
+		PoolStats get_stats()const;
+
+	protected:
+		//! \brief Sets the lifetime operations used for the elements, must be called before any element is added
+		void _set_traits(const ObjectTraits& p_traits) { m_traits = p_traits; }
+
+		//! \brief Moves the element at p_source into the spot at p_destination using the ObjectTraits
+		void _relocate(uint8_t* p_destination, uint8_t* p_source);
+
 	private:
+		struct Page
+		{
+			uint8_t*					data;
+			std::atomic<std::uint64_t>*	occupancy;	// One bit per slot, set when the slot holds a live element
+		};
+
+		// The free list head packs the index of the first free spot in the lower bits and a tag in the upper ones,
+		// the tag changes on every update so that a pop working on a stale head fails ( ABA )
+		static const unsigned int	free_index_bits{ 40 };
+		static const std::uint64_t	free_index_mask{ (static_cast<std::uint64_t>(1) << free_index_bits) - 1 };
+
 		void _safe_release();
 
-		// Resizes array if necessary
+		// Alignment of the elements, natural_alignment is resolved from the size the elements take in the Bag
+		static std::size_t _element_alignment(std::size_t p_element_size, std::size_t p_alignment)
+		{
+			return p_alignment != natural_alignment ? p_alignment : get_natural_alignment(std::max(p_element_size, sizeof(index_t)));
+		}
+
+		// Pages also hold the occupancy words
+		std::size_t _page_alignment()const { return std::max(m_alignment, sizeof(std::uint64_t)); }
+
+		// Size in bytes of a page's elements, occupancy words follow them in the same block
+		std::size_t _page_data_size()const { return align_up((m_page_mask + 1) * m_element_size, sizeof(std::uint64_t)); }
+		std::size_t _page_block_size()const { return _page_data_size() + m_words_per_page * sizeof(std::uint64_t); }
+
+		Page* _allocate_table(std::size_t p_size);
+
+		// Allocates enough pages to hold at least p_count more elements, if p_only_if_empty is true
+		// nothing is done when another thread already refilled the free list
+		void _grow(std::size_t p_count, bool p_only_if_empty);
+
+		// Pops the head of the free list, resizes array if necessary
 		index_t _get_next_spot();
 
+		// Links the chain of free spots [ p_first ... p_last ] ( already linked together ) at the head of the free list
+		void _push_free(index_t p_first, index_t p_last);
+
+		void _set_link(index_t p_index, index_t p_next);
+		index_t _get_link(index_t p_index)const;
+
+		// True if the occupancy bits count p_size elements and the free list links every other spot once, checks a 
+		// content read from a snapshot before using it
+		bool _is_consistent(index_t p_size, index_t p_free_index)const;
+
+		std::atomic<std::uint64_t>& _occupancy_word(index_t p_index)const
+		{
+			return m_pages.load(std::memory_order_acquire)[static_cast<std::size_t>(p_index >> m_page_shift)].occupancy[static_cast<std::size_t>(p_index & m_page_mask) >> 6];
+		}
+
+		std::uint64_t _occupancy_bit(index_t p_index)const
+		{
+			return static_cast<std::uint64_t>(1) << (p_index & m_page_mask & 63);
+		}
+
+		void _set_occupied(index_t p_index, bool p_occupied);
+		void _add_size(std::int64_t p_delta);
+
 	private:
-		// List of free spots in the buffer
-		std::list<index_t>	m_free_list;
+		// Head of the free list, the index of the next free spot is stored in the spot itself
+		std::atomic<std::uint64_t>	m_free_head;
 
-		// Actual buffer
-		uint8_t*				m_data;
+		// Table of pages, each one holds ( m_page_mask + 1 ) elements. When full the table is replaced by a bigger copy,
+		// old tables are kept alive till destruction since concurrent readers might still be using them
+		std::atomic<Page*>			m_pages;
+		std::size_t					m_page_table_size;
+		std::atomic<std::size_t>	m_page_count;
+		std::vector<std::pair<Page*, std::size_t>>	m_retired_tables;
 
-		// Size of the single item in the buffer
+		// Size of the single item in the buffer ( stride )
 		std::size_t			m_element_size;
-		index_t				m_current_size;
+		std::size_t			m_alignment;
+		std::size_t			m_page_shift;
+		std::size_t			m_page_mask;
+		std::size_t			m_words_per_page;
+		std::atomic<index_t> m_capacity;
+		std::atomic<index_t> m_size;
+		std::atomic<index_t> m_high_water;
+		std::uint64_t		m_grow_count;
+
+		bool				m_concurrent;
+		std::mutex			m_grow_mutex;
+
+		ObjectTraits		m_traits;
+		Allocator*			m_allocator;
+
+		grow_callback_t		m_grow_callback;
+		GrowEvent			m_last_grow;
 	};
 
 	// === TEMPLATE ===
 	template <typename object_t, typename ...ctor_args>
-	Bag::index_t Bag::add_object(ctor_args ...p_args)
+	Bag::index_t Bag::add_object(ctor_args&& ...p_args)
 	{
-		assert(m_data != nullptr);
+		assert(sizeof(object_t) <= m_element_size);
 
 		// Taking the first free spot
 		index_t next_spot = _get_next_spot();
 
-		// Constructing object & copying it
-		//object_t object{p_args...};
-		*reinterpret_cast<object_t*>(m_data + next_spot * m_element_size) = object_t(p_args...);
-		//std::memcpy(m_data + next_spot * m_element_size,
-		//	reinterpret_cast<void*>(&object),
-		//	sizeof(object));
+		// Constructing object directly in the spot, no temporaries
+		new (get_element_ptr(next_spot)) object_t(std::forward<ctor_args>(p_args)...);
 
 		return next_spot;
 	}
@@ -85,8 +316,25 @@ namespace ssa
 	template <typename object_t>
 	object_t& Bag::get_object(Bag::index_t p_index)
 	{
-		assert(m_data != nullptr);
+		return *reinterpret_cast<object_t*>(get_element_ptr(p_index));
+	}
 
-		return *reinterpret_cast<object_t*>(m_data + p_index * m_element_size);
+	template <typename func_t>
+	void Bag::for_each(func_t p_func)const
+	{
+		const std::size_t page_count = get_page_count();
+		for (std::size_t p = 0; p < page_count; ++p)
+		{
+			const index_t page_start = static_cast<index_t>(p) << m_page_shift;
+			for (std::size_t w = 0; w < m_words_per_page; ++w)
+			{
+				std::uint64_t bits = m_pages.load(std::memory_order_acquire)[p].occupancy[w].load(std::memory_order_relaxed);
+				while (bits != 0)
+				{
+					p_func(page_start + static_cast<index_t>(w) * 64 + count_trailing_zeros(bits));
+					bits &= bits - 1;
+				}
+			}
+		}
 	}
 }
\ No newline at end of file
@@ -0,0 +1,58 @@
+//! \copyright Mozilla Public License Version 2.0
+//! \note [License]		 license/license.txt
+//! \note [Contributors] license/contributors.txt
+
+#pragma once
+
+// \brief Helpers for raw binary ( de )serialization, values are written in the native layout and endianness
+
+// C++ STD
+#include <cstdint>
+#include <string>
+#include <istream>
+#include <ostream>
+#include <type_traits>
+
+// ssa
+#include "ssa_platform.hpp"
+
+namespace ssa
+{
+	//! \brief Writes the bytes of a trivially copyable value
+	template <typename value_t>
+	bool write_binary(std::ostream& p_stream, const value_t& p_value)
+	{
+		static_assert(std::is_trivially_copyable<value_t>::value, "Only trivially copyable values can be written raw");
+		p_stream.write(reinterpret_cast<const char*>(&p_value), sizeof(value_t));
+		return p_stream.good();
+	}
+
+	//! \brief Reads the bytes of a trivially copyable value written by write_binary()
+	template <typename value_t>
+	bool read_binary(std::istream& p_stream, value_t& p_value)
+	{
+		static_assert(std::is_trivially_copyable<value_t>::value, "Only trivially copyable values can be read raw");
+		p_stream.read(reinterpret_cast<char*>(&p_value), sizeof(value_t));
+		return p_stream.good();
+	}
+
+	//! \brief Writes the length of the string followed by its characters
+	inline bool write_binary(std::ostream& p_stream, const std::string& p_string)
+	{
+		if (!write_binary(p_stream, static_cast<std::uint64_t>(p_string.size())))
+			return false;
+		p_stream.write(p_string.data(), static_cast<std::streamsize>(p_string.size()));
+		return p_stream.good();
+	}
+
+	inline bool read_binary(std::istream& p_stream, std::string& p_string)
+	{
+		std::uint64_t size;
+		if (!read_binary(p_stream, size))
+			return false;
+		p_string.resize(static_cast<std::size_t>(size));
+		if (size > 0)
+			p_stream.read(&p_string[0], static_cast<std::streamsize>(size));
+		return p_stream.good();
+	}
+}
\ No newline at end of file
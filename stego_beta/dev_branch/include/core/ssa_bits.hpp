@@ -0,0 +1,50 @@
+//! \copyright Mozilla Public License Version 2.0
+//! \note [License]		 license/license.txt
+//! \note [Contributors] license/contributors.txt
+
+#pragma once
+
+// \brief Bit manipulation helpers mapped to the compiler intrinsics when available
+
+// C++ STD
+#include <cstdint>
+
+// ssa
+#include "ssa_platform.hpp"
+
+#if defined(ssa_compiler_msvc)
+#include <intrin.h>
+#endif
+
+namespace ssa
+{
+	//! \brief Returns the index of the lowest set bit, p_value must not be 0
+	inline unsigned int count_trailing_zeros(std::uint64_t p_value)
+	{
+#if defined(ssa_compiler_msvc) && defined(ssa_arch_64)
+		unsigned long index;
+		_BitScanForward64(&index, p_value);
+		return static_cast<unsigned int>(index);
+#elif defined(ssa_compiler_msvc)
+		unsigned long index;
+		if (_BitScanForward(&index, static_cast<unsigned long>(p_value)))
+			return static_cast<unsigned int>(index);
+		_BitScanForward(&index, static_cast<unsigned long>(p_value >> 32));
+		return static_cast<unsigned int>(index) + 32;
+#else
+		return static_cast<unsigned int>(__builtin_ctzll(p_value));
+#endif
+	}
+
+	//! \brief Returns the number of set bits
+	inline unsigned int pop_count(std::uint64_t p_value)
+	{
+#if defined(ssa_compiler_msvc) && defined(ssa_arch_64)
+		return static_cast<unsigned int>(__popcnt64(p_value));
+#elif defined(ssa_compiler_msvc)
+		return static_cast<unsigned int>(__popcnt(static_cast<unsigned int>(p_value)) + __popcnt(static_cast<unsigned int>(p_value >> 32)));
+#else
+		return static_cast<unsigned int>(__builtin_popcountll(p_value));
+#endif
+	}
+}
\ No newline at end of file
@@ -4,7 +4,19 @@
 
 #pragma once
 
+#include "ssa_allocator.hpp"
 #include "ssa_bag.hpp"
+#include "ssa_binary_stream.hpp"
+#include "ssa_bits.hpp"
 #include "ssa_entry_point.hpp"
+#include "ssa_frame_arena.hpp"
+#include "ssa_index_sequence.hpp"
+#include "ssa_job_pool.hpp"
 #include "ssa_math.hpp"
+#include "ssa_memory.hpp"
+#include "ssa_page_allocator.hpp"
 #include "ssa_platform.hpp"
+#include "ssa_pool_stats.hpp"
+#include "ssa_span.hpp"
+#include "ssa_type_index.hpp"
+#include "ssa_typed_bag.hpp"
@@ -9,6 +9,7 @@
 
 // C++ STD
 #include <vector>
+#include <string>
 
 typedef std::vector<std::string> cmd_args_t;
 extern int entry_point(cmd_args_t& p_args, ssa::Platform p_platform);
@@ -0,0 +1,129 @@
+//! \copyright Mozilla Public License Version 2.0
+//! \note [License]		 license/license.txt
+//! \note [Contributors] license/contributors.txt
+
+#pragma once
+
+// C++ STD
+#include <cstdlib>
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+#include <new>
+#include <utility>
+#include <type_traits>
+
+// ssa
+#include "ssa_platform.hpp"
+#include "ssa_memory.hpp"
+#include "ssa_allocator.hpp"
+
+namespace ssa
+{
+	//! \brief Linear ( bump ) allocator for memory that lives at most till the end of the frame.
+	//!		Allocating is an aligned pointer increment, nothing is freed individually: reset() releases
+	//!		everything at once. When double buffered the memory allocated during a frame stays valid
+	//!		for the following one too.
+	//!
+	//! If a frame needs more than the capacity the arena falls back to heap blocks, at the next reset() the
+	//!	buffers are reallocated to fit the peak so that steady-state frames never touch the global heap
+	class ssa_export FrameArena
+	{
+	public:
+		//! \brief Allocates the arena's buffer(s)
+		//! \param [in] p_capacity Size in bytes of a single buffer
+		//! \param [in] p_double_buffered If true two buffers are used alternately, one per frame
+		//! \param [in] p_allocator Source of the buffers and of the overflow blocks, must outlive the arena
+		FrameArena(std::size_t p_capacity, bool p_double_buffered = false, Allocator& p_allocator = get_default_allocator());
+
+		//! \brief Deallocates all the buffers, nothing allocated from the arena should be used afterwards
+		~FrameArena();
+
+		FrameArena(const FrameArena&) = delete;
+		FrameArena& operator=(const FrameArena&) = delete;
+
+		//! \brief Allocates p_size bytes aligned to p_alignment ( power of two ), never returns nullptr
+		void* allocate(std::size_t p_size, std::size_t p_alignment = default_alignment);
+
+		//! \brief Allocates an uninitialized array of p_count elements
+		template <typename object_t>
+		object_t* allocate_array(std::size_t p_count)
+		{
+			return static_cast<object_t*>(allocate(sizeof(object_t)* p_count, std::alignment_of<object_t>::value));
+		}
+
+		//! \brief Ends the frame: switches buffer ( if double buffered ) and makes all its memory available again
+		void reset();
+
+		//! \brief Returns the size in bytes of the buffer currently in use
+		std::size_t get_capacity()const { return m_buffers[m_current].capacity; }
+
+		//! \brief Returns the number of bytes ( alignment padding included ) allocated since the last reset()
+		std::size_t get_used()const { return m_used; }
+
+		//! \brief Returns the number of allocations that did not fit and went to the heap
+		std::uint64_t get_overflow_count()const { return m_overflow_count; }
+
+	private:
+		struct Buffer
+		{
+			std::uint8_t*	data;
+			std::size_t		offset;
+			std::size_t		capacity;
+		};
+
+		Buffer						m_buffers[2];
+		unsigned int				m_current;
+		bool						m_double_buffered;
+
+		std::size_t					m_used;
+		std::size_t					m_peak;
+		std::uint64_t				m_overflow_count;
+
+		// Blocks allocated when the buffer was full, released at reset()
+		std::vector<std::pair<void*, std::size_t>>	m_overflow_blocks[2];
+
+		Allocator*					m_allocator;
+	};
+
+	//! \brief STL-compatible allocator drawing from a FrameArena, deallocate() does nothing.
+	//!		Containers using it must not outlive the frame(s) the arena keeps their memory for
+	template <typename object_t>
+	class ArenaAllocator
+	{
+	public:
+		typedef object_t value_type;
+
+		template <typename other_t>
+		struct rebind
+		{
+			typedef ArenaAllocator<other_t> other;
+		};
+
+	public:
+		explicit ArenaAllocator(FrameArena& p_arena) : m_arena{ &p_arena } { }
+
+		template <typename other_t>
+		ArenaAllocator(const ArenaAllocator<other_t>& p_other) : m_arena{ &p_other.get_arena() } { }
+
+		object_t* allocate(std::size_t p_count) { return m_arena->allocate_array<object_t>(p_count); }
+		void deallocate(object_t*, std::size_t) { }
+
+		FrameArena& get_arena()const { return *m_arena; }
+
+	private:
+		FrameArena* m_arena;
+	};
+
+	template <typename first_t, typename second_t>
+	bool operator==(const ArenaAllocator<first_t>& p_first, const ArenaAllocator<second_t>& p_second)
+	{
+		return &p_first.get_arena() == &p_second.get_arena();
+	}
+
+	template <typename first_t, typename second_t>
+	bool operator!=(const ArenaAllocator<first_t>& p_first, const ArenaAllocator<second_t>& p_second)
+	{
+		return !(p_first == p_second);
+	}
+}
\ No newline at end of file
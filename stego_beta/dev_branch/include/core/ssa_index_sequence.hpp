@@ -0,0 +1,26 @@
+//! \copyright Mozilla Public License Version 2.0
+//! \note [License]		 license/license.txt
+//! \note [Contributors] license/contributors.txt
+
+#pragma once
+
+// C++ STD
+#include <cstddef>
+
+// \brief Compile-time sequence of indices to expand a parameter pack together with its positions, std::index_sequence
+//	is C++14
+
+namespace ssa
+{
+	template <std::size_t ...indices>
+	struct IndexSequence { };
+
+	template <std::size_t count, std::size_t ...indices>
+	struct MakeIndexSequence : MakeIndexSequence<count - 1, count - 1, indices...> { };
+
+	template <std::size_t ...indices>
+	struct MakeIndexSequence<0, indices...>
+	{
+		typedef IndexSequence<indices...> type;
+	};
+}
\ No newline at end of file
@@ -0,0 +1,128 @@
+//! \copyright Mozilla Public License Version 2.0
+//! \note [License]		 license/license.txt
+//! \note [Contributors] license/contributors.txt
+
+#pragma once
+
+// C++ STD
+#include <cstddef>
+#include <cstdint>
+#include <atomic>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <vector>
+
+// ssa
+#include "ssa_platform.hpp"
+
+namespace ssa
+{
+	//! \brief Fixed set of worker threads running jobs, every worker has its own queue and steals from the others
+	//!		when it runs out of work.
+	//!
+	//! Workers are numbered from 0 to get_worker_count() - 1, worker 0 is the thread calling wait_idle(), it runs
+	//!	jobs too while waiting. Jobs receive the index of the worker running them, it can be used to index per-worker
+	//! data and to push more jobs on the same queue ( they are run first, LIFO ), other workers steal the oldest ones
+	class ssa_export JobPool
+	{
+	public:
+		typedef std::function<void(std::size_t p_worker)> job_t;
+
+		//! \brief Number of unfinished jobs of a group, see push() and wait()
+		typedef std::atomic<std::size_t> counter_t;
+
+	public:
+		//! \brief Starts p_worker_count - 1 threads, the calling thread being the first worker
+		//! \param [in] p_worker_count Number of workers, 0 to use one per hardware thread
+		JobPool(std::size_t p_worker_count = 0);
+
+		//! \brief Stops the threads, queued jobs are discarded
+		~JobPool();
+
+		JobPool(const JobPool&) = delete;
+		JobPool& operator=(const JobPool&) = delete;
+
+		//! \brief Number of workers, calling thread included
+		std::size_t get_worker_count()const { return m_worker_count; }
+
+		//! \brief Queues a job, can be called from any thread, jobs included
+		//! \param [in] p_worker Queue the job is pushed to, usually the worker running the current job
+		//! \param [in] p_counter Incremented now and decremented when the job is done, can be null
+		void push(const job_t& p_job, std::size_t p_worker = 0, counter_t* p_counter = nullptr);
+
+		//! \brief Runs jobs on the calling thread until all the pushed jobs, and the ones they pushed, are done.
+		//!		Must not be called from a job
+		void wait_idle();
+
+		//! \brief Runs jobs until the counter reaches 0, can be called from a job to wait for the ones it pushed
+		//! \param [in] p_worker Worker calling this, 0 if not called from a job
+		void wait(const counter_t& p_counter, std::size_t p_worker);
+
+	private:
+		struct QueuedJob
+		{
+			job_t		job;
+			counter_t*	counter;
+		};
+
+		struct Queue
+		{
+			std::mutex				mutex;
+			std::deque<QueuedJob>	jobs;
+		};
+
+		// Thread function of workers 1..n
+		void _worker_loop(std::size_t p_worker);
+
+		// Pops a job from the worker's queue or steals one from the others and runs it, false if there was none
+		bool _run_one(std::size_t p_worker);
+
+		// True if there is a queued job, or the pool is idle / stopping for the ones waiting on it
+		bool _can_wake(bool p_waiting_idle)const;
+
+	private:
+		std::size_t					m_worker_count;
+		std::unique_ptr<Queue[]>	m_queues;
+		std::vector<std::thread>	m_threads;
+
+		std::atomic<std::size_t>	m_queued;		// Jobs pushed but not started
+		std::atomic<std::size_t>	m_outstanding;	// Jobs pushed but not finished
+		std::atomic<bool>			m_stop;
+
+		// Sleeping workers wake up when a job is pushed, wait_idle() also when the pool is idle
+		std::mutex					m_sleep_mutex;
+		std::condition_variable		m_sleep_cv;
+	};
+
+	//! \brief Per-worker copies of a value ( scratch buffers, partial sums ), padded to avoid false sharing
+	template <typename object_t>
+	class PerWorker
+	{
+	public:
+		PerWorker() { }
+		explicit PerWorker(std::size_t p_worker_count) : m_slots(p_worker_count) { }
+
+		//! \brief Sets the number of copies, resetting all of them to the default value
+		void reset(std::size_t p_worker_count) { m_slots.assign(p_worker_count, Slot()); }
+
+		std::size_t get_size()const { return m_slots.size(); }
+
+		object_t& operator[](std::size_t p_worker) { return m_slots[p_worker].value; }
+		const object_t& operator[](std::size_t p_worker)const { return m_slots[p_worker].value; }
+
+	private:
+		struct Slot
+		{
+			Slot() : value() { }
+
+			object_t		value;
+			std::uint8_t	padding[64];
+		};
+
+		std::vector<Slot> m_slots;
+	};
+}
\ No newline at end of file
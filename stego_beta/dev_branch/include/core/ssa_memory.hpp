@@ -0,0 +1,77 @@
+//! \copyright Mozilla Public License Version 2.0
+//! \note [License]		 license/license.txt
+//! \note [Contributors] license/contributors.txt
+
+#pragma once
+
+// \brief Aligned allocation helpers, mapped to the platform's functions
+
+// C++ STD
+#include <cstdlib>
+#include <cstddef>
+#include <cassert>
+
+// ssa
+#include "ssa_platform.hpp"
+
+#if defined(ssa_compiler_msvc)
+#include <malloc.h>
+#endif
+
+namespace ssa
+{
+	//! \brief Alignment used when none is specified, enough for SSE loads
+	const std::size_t default_alignment{ 16 };
+
+	//! \brief Alignment argument of the pools asking for the element's own alignment, elements are packed without padding
+	const std::size_t natural_alignment{ 0 };
+
+	//! \brief Returns true if p_value is a power of two ( 0 excluded )
+	inline bool is_power_of_two(std::size_t p_value)
+	{
+		return p_value != 0 && (p_value & (p_value - 1)) == 0;
+	}
+
+	//! \brief Rounds p_value up to the next multiple of p_alignment, which must be a power of two
+	inline std::size_t align_up(std::size_t p_value, std::size_t p_alignment)
+	{
+		assert(is_power_of_two(p_alignment));
+		return (p_value + p_alignment - 1) & ~(p_alignment - 1);
+	}
+
+	//! \brief Returns the highest power of two dividing p_size, at most default_alignment. Any type of that size is 
+	//!		aligned to it at most, packing elements at this alignment adds no padding
+	inline std::size_t get_natural_alignment(std::size_t p_size)
+	{
+		const std::size_t lowest_bit = p_size & (~p_size + 1);
+		return lowest_bit == 0 || lowest_bit > default_alignment ? default_alignment : lowest_bit;
+	}
+
+	//! \brief Allocates p_size bytes aligned to p_alignment ( power of two ), must be released with aligned_free
+	//! \return Pointer to the memory, nullptr if allocation failed
+	inline void* aligned_malloc(std::size_t p_size, std::size_t p_alignment)
+	{
+		assert(is_power_of_two(p_alignment));
+		if (p_alignment < sizeof(void*))
+			p_alignment = sizeof(void*);
+
+#if defined(ssa_compiler_msvc)
+		return _aligned_malloc(p_size, p_alignment);
+#else
+		void* memory{ nullptr };
+		if (posix_memalign(&memory, p_alignment, p_size) != 0)
+			return nullptr;
+		return memory;
+#endif
+	}
+
+	//! \brief Releases memory allocated with aligned_malloc
+	inline void aligned_free(void* p_memory)
+	{
+#if defined(ssa_compiler_msvc)
+		_aligned_free(p_memory);
+#else
+		std::free(p_memory);
+#endif
+	}
+}
\ No newline at end of file
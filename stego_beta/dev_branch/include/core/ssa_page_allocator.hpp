@@ -0,0 +1,48 @@
+//! \copyright Mozilla Public License Version 2.0
+//! \note [License]		 license/license.txt
+//! \note [Contributors] license/contributors.txt
+
+#pragma once
+
+// C++ STD
+#include <cstddef>
+#include <atomic>
+
+// ssa
+#include "ssa_allocator.hpp"
+
+namespace ssa
+{
+	//! \brief Allocator requesting memory directly from the operating system ( mmap on Linux, VirtualAlloc on Windows ),
+	//!		sizes are rounded up to the page size. If huge pages are requested it first tries explicit huge pages
+	//!		( MAP_HUGETLB / MEM_LARGE_PAGES ) and falls back to normal pages when the system has none available,
+	//!		on Linux the fallback is still marked for transparent huge pages.
+	//!
+	//! Meant for big pools ( use a page size of some thousand elements ), every allocation costs at least one page
+	class ssa_export PageAllocator : public Allocator
+	{
+	public:
+		//! \param [in] p_huge_pages True to back allocations with huge pages when possible
+		explicit PageAllocator(bool p_huge_pages = true);
+
+		void* allocate(std::size_t p_size, std::size_t p_alignment) override;
+		void deallocate(void* p_memory, std::size_t p_size) override;
+
+		//! \brief Returns the size of a normal page, alignments up to it are honored
+		std::size_t get_page_size()const { return m_page_size; }
+
+		//! \brief Returns the size of a huge page, 0 if huge pages are not supported or not requested
+		std::size_t get_huge_page_size()const { return m_huge_page_size; }
+
+		//! \brief Returns the number of allocations that have been served with explicit huge pages
+		std::size_t get_huge_allocation_count()const { return m_huge_allocations.load(std::memory_order_relaxed); }
+
+	private:
+		std::size_t _round_up(std::size_t p_size, bool p_huge)const;
+
+	private:
+		std::size_t					m_page_size;
+		std::size_t					m_huge_page_size;
+		std::atomic<std::size_t>	m_huge_allocations;
+	};
+}
\ No newline at end of file
@@ -24,6 +24,7 @@
 #endif 
 
 // Platform macros
+#if defined(_WIN32)
 // Reserved for Windows 8 + // @TODO : 
 #include <winapifamily.h>
 
@@ -32,9 +33,13 @@
 #define ssa_os_windows
 #elif WINAPI_FAMILY == WINAPI_FAMILY_PHONE_APP
 #define ssa_os_windows_phone
+#else
+#error Windows API family not recognized and probably not supported, see requirements.txt for more informations
+#endif
+
 #elif defined(__linux__)
+// Only the core and entity modules build on Linux, window / input / graphics are Windows only
 #define ssa_os_linux
-#error All linux-based operating systems are not supported yet
 #elif defined(macintosh) || defined(Macintosh) || (defined(__APPLE__) && defined(__MACH__))
 #define ssa_os_macos
 #error All MacOses are not supported yet
@@ -51,6 +56,11 @@
 #define ssa_ARCH_32
 #endif
 
+// SIMD, SSE2 is always available on x64
+#if defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2) || defined(__SSE2__)
+#define ssa_sse2
+#endif
+
 // Language specific 
 #if defined(ssa_compiler_msvc)
 #define ssa_force_inline __forceinline
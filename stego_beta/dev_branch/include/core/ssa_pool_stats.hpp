@@ -0,0 +1,60 @@
+//! \copyright Mozilla Public License Version 2.0
+//! \note [License]		 license/license.txt
+//! \note [Contributors] license/contributors.txt
+
+#pragma once
+
+// C++ STD
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <utility>
+#include <ostream>
+
+// ssa
+#include "ssa_platform.hpp"
+
+namespace ssa
+{
+	//! \brief Snapshot of the occupancy and memory usage of a pool ( Bag, ResourceBatch ), counts are in elements
+	struct PoolStats
+	{
+		PoolStats() :
+			capacity{ 0 },
+			live{ 0 },
+			high_water{ 0 },
+			bytes_reserved{ 0 },
+			bytes_used{ 0 },
+			grow_events{ 0 },
+			free_list_length{ 0 } { }
+
+		std::uint64_t capacity;			// Number of elements the pool can hold without growing
+		std::uint64_t live;				// Number of elements currently alive
+		std::uint64_t high_water;		// Highest number of elements alive at the same time
+		std::uint64_t bytes_reserved;	// Memory allocated by the pool, bookkeeping included
+		std::uint64_t bytes_used;		// Memory used by live elements
+		std::uint64_t grow_events;		// Number of times the pool allocated more memory
+		std::uint64_t free_list_length;	// Number of free spots ready to be reused
+	};
+
+	//! \brief List of pools identified by name
+	typedef std::vector<std::pair<std::string, PoolStats>> pool_stats_list_t;
+
+	//! \brief Writes one line per pool in a human-readable format
+	inline void write_pool_stats(std::ostream& p_stream, const pool_stats_list_t& p_pools)
+	{
+		for (const auto& pool : p_pools)
+		{
+			const PoolStats& stats = pool.second;
+			p_stream << pool.first 
+				<< " capacity: " << stats.capacity
+				<< " live: " << stats.live
+				<< " high_water: " << stats.high_water
+				<< " bytes_reserved: " << stats.bytes_reserved
+				<< " bytes_used: " << stats.bytes_used
+				<< " grow_events: " << stats.grow_events
+				<< " free_list: " << stats.free_list_length
+				<< '\n';
+		}
+	}
+}
\ No newline at end of file
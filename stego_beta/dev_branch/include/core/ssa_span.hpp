@@ -0,0 +1,38 @@
+//! \copyright Mozilla Public License Version 2.0
+//! \note [License]		 license/license.txt
+//! \note [Contributors] license/contributors.txt
+
+#pragma once
+
+// C++ STD
+#include <cstddef>
+#include <cassert>
+
+namespace ssa
+{
+	//! \brief Non-owning view of contiguous objects
+	template <typename object_t>
+	class Span
+	{
+	public:
+		Span() : m_data{ nullptr }, m_size{ 0 } { }
+		Span(object_t* p_data, std::size_t p_size) : m_data{ p_data }, m_size{ p_size } { }
+
+		object_t* data()const { return m_data; }
+		std::size_t size()const { return m_size; }
+		bool empty()const { return m_size == 0; }
+
+		object_t* begin()const { return m_data; }
+		object_t* end()const { return m_data + m_size; }
+
+		object_t& operator[](std::size_t p_index)const
+		{
+			assert(p_index < m_size);
+			return m_data[p_index];
+		}
+
+	private:
+		object_t*	m_data;
+		std::size_t	m_size;
+	};
+}
\ No newline at end of file
@@ -0,0 +1,66 @@
+//! \copyright Mozilla Public License Version 2.0
+//! \note [License]		 license/license.txt
+//! \note [Contributors] license/contributors.txt
+
+#pragma once
+
+// C++ STD
+#include <cstddef>
+#include <atomic>
+
+// ssa
+#include "ssa_platform.hpp"
+
+namespace ssa
+{
+	//! \brief Dense index assigned to every type of a family ( components, systems.. ) the first time it is asked for,
+	//!		meant to replace typeid().hash_code() map lookups with array indexing.
+	//!
+	//! Indices depend on the order types are first used in, they are not stable across runs and are per module ( the
+	//!	engine is a static library ). Anything saved or compared between runs must use something else ( type names,
+	//!	registration order ). Thread-safe, two threads asking for a new type at the same time might skip an index
+	template <typename family_t>
+	class TypeIndex
+	{
+	public:
+		//! \brief Returns the index of the type, the same for the whole run
+		template <typename type_t>
+		static std::size_t get()
+		{
+			const std::size_t index = Slot<type_t>::value.load(std::memory_order_acquire);
+			if (index != 0)
+				return index - 1;
+			return _assign(Slot<type_t>::value) - 1;
+		}
+
+		//! \brief Returns an upper bound of the indices assigned so far
+		static std::size_t get_count() { return s_counter.load(std::memory_order_acquire); }
+
+	private:
+		// Zero-initialized before any dynamic initialization, usable from static constructors. 0 is unassigned, 
+		// index + 1 otherwise
+		template <typename type_t>
+		struct Slot
+		{
+			static std::atomic<std::size_t> value;
+		};
+
+		static std::size_t _assign(std::atomic<std::size_t>& p_slot)
+		{
+			const std::size_t desired = s_counter.fetch_add(1) + 1;
+			std::size_t expected = 0;
+			if (!p_slot.compare_exchange_strong(expected, desired))
+				return expected;	// Assigned by another thread meanwhile
+			return desired;
+		}
+
+		static std::atomic<std::size_t> s_counter;
+	};
+
+	template <typename family_t>
+	std::atomic<std::size_t> TypeIndex<family_t>::s_counter;
+
+	template <typename family_t>
+	template <typename type_t>
+	std::atomic<std::size_t> TypeIndex<family_t>::Slot<type_t>::value;
+}
\ No newline at end of file
@@ -0,0 +1,88 @@
+//! \copyright Mozilla Public License Version 2.0
+//! \note [License]		 license/license.txt
+//! \note [Contributors] license/contributors.txt
+
+#pragma once
+
+// C++ STD
+#include <utility>
+#include <new>
+#include <type_traits>
+#include <algorithm>
+
+// ssa
+#include "ssa_bag.hpp"
+
+namespace ssa
+{
+	//! \brief Bag holding objects of a single type with real lifetimes: objects are constructed in place,
+	//!		moved when the bag relocates them and destroyed when recycled or when the bag goes out of scope.
+	//!		It can still be accessed through the type-erased Bag interface
+	//!
+	//! Trivially copyable types need none of this, they are handled as raw bytes ( memcpy / memset ) like in a plain Bag
+	//!	and the bag can be snapshotted
+	template <typename object_t>
+	class ssa_export TypedBag : public Bag
+	{
+	public:
+		//! \brief Constructs a new instance, see Bag::Bag(). The alignment is never lower than object_t's own one
+		TypedBag(std::size_t p_initial_capacity, std::size_t p_page_size = Bag::default_page_size, 
+			std::size_t p_alignment = natural_alignment, Allocator& p_allocator = get_default_allocator());
+
+		//! \brief Constructs a new object in place in the first free spot, arguments are perfectly forwarded
+		//! \return Index of the new object
+		template <typename ...ctor_args>
+		index_t emplace(ctor_args&& ...p_args);
+
+		object_t& get(index_t p_index) { return get_object<object_t>(p_index); }
+
+		//! \brief Returns the lifetime operations for object_t, both null if it is trivially copyable
+		static ObjectTraits get_object_traits();
+
+	private:
+		static void _destroy_object(void* p_object);
+		static void _relocate_object(void* p_destination, void* p_source);
+	};
+
+	template <typename object_t>
+	TypedBag<object_t>::TypedBag(std::size_t p_initial_capacity, std::size_t p_page_size, std::size_t p_alignment, Allocator& p_allocator) :
+		Bag(sizeof(object_t), p_initial_capacity, p_page_size, std::max<std::size_t>(p_alignment, std::alignment_of<object_t>::value), p_allocator)
+	{
+		_set_traits(get_object_traits());
+	}
+
+	template <typename object_t>
+	Bag::ObjectTraits TypedBag<object_t>::get_object_traits()
+	{
+		ObjectTraits traits;
+		traits.destroy = nullptr;
+		traits.relocate = nullptr;
+		if (!std::is_trivially_copyable<object_t>::value)
+		{
+			traits.destroy = &TypedBag<object_t>::_destroy_object;
+			traits.relocate = &TypedBag<object_t>::_relocate_object;
+		}
+		return traits;
+	}
+
+	template <typename object_t>
+	template <typename ...ctor_args>
+	Bag::index_t TypedBag<object_t>::emplace(ctor_args&& ...p_args)
+	{
+		return add_object<object_t>(std::forward<ctor_args>(p_args)...);
+	}
+
+	template <typename object_t>
+	void TypedBag<object_t>::_destroy_object(void* p_object)
+	{
+		static_cast<object_t*>(p_object)->~object_t();
+	}
+
+	template <typename object_t>
+	void TypedBag<object_t>::_relocate_object(void* p_destination, void* p_source)
+	{
+		object_t* source = static_cast<object_t*>(p_source);
+		new (p_destination) object_t(std::move(*source));
+		source->~object_t();
+	}
+}
\ No newline at end of file
@@ -0,0 +1,229 @@
+//! \copyright Mozilla Public License Version 2.0
+//! \note [License]		 license/license.txt
+//! \note [Contributors] license/contributors.txt
+
+#pragma once
+
+// C++ STD
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+#include <type_traits>
+
+// ssa
+#include "ssa_component.hpp"
+#include "ssa_signature.hpp"
+#include "../core/ssa_bag.hpp"
+#include "../core/ssa_allocator.hpp"
+#include "../core/ssa_pool_stats.hpp"
+#include "../core/ssa_span.hpp"
+
+namespace ssa
+{
+	// Forward declaration
+	class Entity;
+
+	//! \brief Maximum number of fields of a component stored as structure of arrays
+	const std::size_t max_component_fields{ 16 };
+
+	//! \brief Member of a component stored in its own column, see ComponentFactory::register_soa_component()
+	struct ComponentField
+	{
+		std::size_t offset;		// From the beginning of the component
+		std::size_t size;
+	};
+
+	//! \brief Returns the offset of a member from the beginning of the component
+	template <typename component_t, typename field_t>
+	std::size_t get_field_offset(field_t component_t::* p_field)
+	{
+		// Only the address is taken, nothing is constructed or read
+		const typename std::aligned_storage<sizeof(component_t), std::alignment_of<component_t>::value>::type storage = { };
+		const component_t* component = reinterpret_cast<const component_t*>(&storage);
+		return static_cast<std::size_t>(reinterpret_cast<const uint8_t*>(&(component->*p_field)) - reinterpret_cast<const uint8_t*>(component));
+	}
+
+	//! \brief What a table needs to know to store a component type without knowing the type
+	struct ComponentLayout
+	{
+		std::size_t			size;
+		std::size_t			alignment;
+		Bag::ObjectTraits	traits;		// Both null for trivially copyable types ( memcpy / nothing to destroy )
+
+		// Structure of arrays: the column only holds the Component header, every field has its own column of 
+		// field_alignment aligned, tightly packed values. 0 if the component is stored whole
+		std::size_t			field_count;
+		std::size_t			field_alignment;
+		ComponentField		fields[max_component_fields];
+	};
+
+	//! \brief Table holding the components of all the entities with exactly the same set of component types ( signature ).
+	//!		Rows are stored in fixed-size chunks, inside a chunk every component type has its own contiguous column ( SoA ),
+	//!		iterating a few component types streams linearly through memory.
+	//!
+	//! Rows are always dense, removing one moves the last row in its place. Moved entities are relinked ( component 
+	//!	pointers, row, Component::m_id ) so that pointers held by Entity stay valid
+	//!
+	//! Components with a field layout ( ComponentLayout::field_count ) are split further: their column holds the headers
+	//!	and every field gets a column of its own, systems read them as parallel arrays ( get_field_span() )
+	class ssa_export Archetype
+	{
+	public:
+		typedef Component::signature_t signature_t;
+
+		//! \brief Size in bytes of a chunk if not specified otherwise, it is enlarged if a single row does not fit
+		static const std::size_t default_chunk_bytes{ 16 * 1024 };
+
+	public:
+		//! \brief Creates an empty table, chunks are allocated when rows are added
+		//! \param [in] p_signature Component types stored in the table
+		//! \param [in] p_layouts Layouts of all the component types, indexed by type
+		//! \param [in] p_allocator Source of the chunks, must outlive the table
+		Archetype(const signature_t& p_signature, const ComponentLayout* p_layouts, Allocator& p_allocator, 
+			std::size_t p_chunk_bytes = default_chunk_bytes);
+
+		//! \brief Destroys all the components and releases the chunks
+		~Archetype();
+
+		Archetype(const Archetype&) = delete;
+		Archetype& operator=(const Archetype&) = delete;
+
+		const signature_t& get_signature()const { return m_signature; }
+
+		//! \brief Returns the number of rows ( entities ) in the table
+		std::size_t get_size()const { return m_size; }
+
+		std::size_t get_rows_per_chunk()const { return m_rows_per_chunk; }
+		std::size_t get_chunk_count()const { return m_chunks.size(); }
+
+		//! \brief Returns the number of rows in the chunk, every chunk but the last one is full
+		std::size_t get_chunk_size(std::size_t p_chunk)const
+		{
+			const std::size_t first = p_chunk * m_rows_per_chunk;
+			return m_size <= first ? 0 : (m_size - first < m_rows_per_chunk ? m_size - first : m_rows_per_chunk);
+		}
+
+		//! \brief Returns the first element of the type's column inside the chunk, p_type must be in the signature
+		uint8_t* get_column(std::size_t p_chunk, Component::type_t p_type)const
+		{
+			return m_chunks[p_chunk] + _get_column(p_type).offset;
+		}
+
+		template <typename component_t>
+		component_t* get_column(std::size_t p_chunk, Component::type_t p_type)const
+		{
+			return reinterpret_cast<component_t*>(get_column(p_chunk, p_type));
+		}
+
+		//! \brief Returns the distance in bytes between two elements of the type's column
+		std::size_t get_column_stride(Component::type_t p_type)const { return _get_column(p_type).stride; }
+
+		//! \brief True if the type's fields are stored in their own columns
+		bool is_split(Component::type_t p_type)const { return _get_column(p_type).layout.field_count != 0; }
+
+		//! \brief Returns the row after the last one of the chunk holding p_row ( or the size ), field spans can't cross chunks
+		std::size_t get_chunk_end(std::size_t p_row)const
+		{
+			const std::size_t end = (p_row / m_rows_per_chunk + 1) * m_rows_per_chunk;
+			return end < m_size ? end : m_size;
+		}
+
+		//! \brief Returns the address of a field of the component in the row, p_type must be split
+		uint8_t* get_field_ptr(std::size_t p_row, Component::type_t p_type, std::size_t p_field)const
+		{
+			const Column& column = _get_column(p_type);
+			assert(p_field < column.layout.field_count);
+			return m_chunks[p_row / m_rows_per_chunk] + m_field_offsets[column.first_field + p_field] + 
+				(p_row % m_rows_per_chunk) * column.layout.fields[p_field].size;
+		}
+
+		//! \brief Returns the values of a field for the rows [ p_first_row, p_last_row ), they must be in the same chunk
+		template <typename field_t>
+		Span<field_t> get_field_span(std::size_t p_first_row, std::size_t p_last_row, Component::type_t p_type, std::size_t p_field)const
+		{
+			assert(p_first_row < p_last_row && p_last_row <= get_chunk_end(p_first_row));
+			assert(_get_column(p_type).layout.fields[p_field].size == sizeof(field_t));
+			return Span<field_t>(reinterpret_cast<field_t*>(get_field_ptr(p_first_row, p_type, p_field)), p_last_row - p_first_row);
+		}
+
+		//! \brief Copies the fields of a whole component into the field columns of the row
+		void scatter_fields(std::size_t p_row, Component::type_t p_type, const void* p_component);
+
+		//! \brief Returns the address of the component of the specified type in the row
+		uint8_t* get_element_ptr(std::size_t p_row, Component::type_t p_type)const
+		{
+			const Column& column = _get_column(p_type);
+			return m_chunks[p_row / m_rows_per_chunk] + column.offset + (p_row % m_rows_per_chunk) * column.stride;
+		}
+
+		Component* get_component(std::size_t p_row, Component::type_t p_type)const
+		{
+			return reinterpret_cast<Component*>(get_element_ptr(p_row, p_type));
+		}
+
+		//! \brief Returns the entity owning the row
+		Entity* get_entity(std::size_t p_row)const { return get_component(p_row, m_columns[0].type)->get_entity(); }
+
+		//! \brief Appends a row, components are left unconstructed and the owner must link the entity to the table
+		//! \return Index of the new row
+		std::size_t add_row() { return add_rows(1); }
+
+		//! \brief Appends p_count rows, allocating all the chunks needed at once. Same as add_row()
+		//! \return Index of the first new row, the others follow it
+		std::size_t add_rows(std::size_t p_count);
+
+		//! \brief Moves the entity at p_row of p_source into a new row of this table. Components of the types in both 
+		//!		signatures are relocated and relinked, the ones missing here are destroyed and unlinked, the ones missing 
+		//!		in p_source are left unconstructed. The entity is linked to this table
+		//! \return Index of the new row
+		std::size_t migrate_row(Archetype& p_source, std::size_t p_row);
+
+		//! \brief Destroys the components in the row and unlinks them and the table from the entity, the last row is moved in its place
+		void remove_row(std::size_t p_row);
+
+		//! \brief Releases the chunks left empty by removed rows
+		void shrink();
+
+		//! \brief Returns occupancy and memory usage of the table, an element is a row
+		PoolStats get_stats()const;
+
+	private:
+		struct Column
+		{
+			Component::type_t	type;
+			std::size_t			offset;	// From the beginning of the chunk
+			std::size_t			stride;
+			ComponentLayout		layout;
+			std::size_t			first_field;	// In m_field_offsets, if split
+		};
+
+		const Column& _get_column(Component::type_t p_type)const { return m_columns[m_column_index[static_cast<std::size_t>(p_type)]]; }
+
+		// Fills the hole at p_row with the last row and drops the last row, components at p_row must have been destroyed or moved
+		void _erase_row(std::size_t p_row);
+
+		// Moves the fields of a split component from a row of p_source to a row of this table
+		void _move_fields(const Column& p_column, std::size_t p_row, const Archetype& p_source, std::size_t p_source_row);
+
+		// Moves a component from p_source to p_destination and links it to its entity at p_row
+		static void _relocate(const ComponentLayout& p_layout, uint8_t* p_destination, uint8_t* p_source);
+		static void _destroy(const ComponentLayout& p_layout, uint8_t* p_object);
+		void _link(std::size_t p_row, Component::type_t p_type);
+
+	private:
+		signature_t												m_signature;
+		std::vector<Column>										m_columns;
+		std::vector<std::uint16_t>								m_column_index;	// Indexed by type up to the highest in the signature, only valid for the types in it
+		std::vector<std::size_t>								m_field_offsets;	// From the beginning of the chunk, for split types
+
+		std::vector<uint8_t*>									m_chunks;
+		std::size_t												m_chunk_bytes;
+		std::size_t												m_chunk_alignment;
+		std::size_t												m_rows_per_chunk;
+		std::size_t												m_size;
+		std::size_t												m_high_water;
+		std::uint64_t											m_grow_count;
+
+		Allocator*												m_allocator;
+	};
+}
\ No newline at end of file
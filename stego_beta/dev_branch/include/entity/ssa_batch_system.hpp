@@ -0,0 +1,143 @@
+//! \copyright Mozilla Public License Version 2.0
+//! \note [License]		 license/license.txt
+//! \note [Contributors] license/contributors.txt
+
+#pragma once
+
+// C++ STD
+#include <cstddef>
+#include <type_traits>
+#include <algorithm>
+#include <cassert>
+
+// ssa
+#include "ssa_system.hpp"
+#include "ssa_archetype.hpp"
+#include "../core/ssa_span.hpp"
+#include "../core/ssa_index_sequence.hpp"
+
+namespace ssa
+{
+	//! \brief System receiving the components it needs as contiguous arrays, one call per batch of entities instead of one
+	//!		per entity, no EntityHandle nor type lookup involved.
+	//!
+	//! The component types are registered when the system is added. A const type is declared as read, the others as
+	//!	written ( see System::read_component() ), so batch systems touching different types run in parallel. Batches are 
+	//! processed in chunked mode ( see System::set_chunk_size() ), process_batch() must be thread-safe if the looper has 
+	//!	more than one worker.
+	//!
+	//! Batching needs archetype storage ( see ComponentFactory::StorageMode ): a batch is a run of rows inside a table chunk 
+	//!	and the spans point straight into the columns. In pools mode components of different types are not stored side by 
+	//!	side, every batch holds a single entity and process_batch() costs a virtual call per entity like System::process().
+	//!
+	//!	The types are registered at their own alignment so that the columns are plain arrays. A type registered before with 
+	//!	a higher alignment has padded rows, its batches hold a single row as well. Types registered as structure of arrays
+	//!	( see ComponentFactory::register_soa_component() ) have no whole component to point to and can't be batched, read 
+	//!	their fields with System::get_field_span() from process_rows()
+	template <typename ...components_t>
+	class BatchSystem : public System
+	{
+		static_assert(sizeof...(components_t) > 0, "A batch system needs at least one component type");
+	public:
+		//! \brief Entities handed to a worker at once if not specified otherwise, see System::set_chunk_size()
+		static const std::size_t default_chunk_size{ 4096 };
+
+	public:
+		BatchSystem() { set_chunk_size(default_chunk_size); }
+
+		//! \brief Processes the i-th entity of the batch reading / writing the i-th element of every span, all the spans
+		//!		have the same size
+		//! \param [in] p_worker Index of the worker running the batch, less than get_worker_count()
+		virtual void process_batch(std::size_t p_worker, Span<components_t>... p_components) = 0;
+
+		void preprocess() override { }
+		void finalize() override { }
+
+		//! \brief Forwards single entities to process_batch() on the worker processing them, only used if chunked mode is 
+		//!		disabled in pools mode
+		void process(EntityHandle& p_entity) override
+		{
+			Entity* entity = &p_entity.get();
+			process_range(&entity, &entity + 1, p_entity.get_worker());
+		}
+
+		void process_range(Entity* const* p_begin, Entity* const* p_end, std::size_t p_worker) override
+		{
+			for (Entity* const* entity = p_begin; entity != p_end; ++entity)
+				_process_entity(**entity, p_worker, typename MakeIndexSequence<sizeof...(components_t)>::type());
+		}
+
+		void process_rows(Archetype& p_archetype, std::size_t p_first_row, std::size_t p_last_row, std::size_t p_worker) override
+		{
+			// Spans cannot cross the end of a chunk, nor step over padded rows
+			const std::size_t rows_per_chunk = _is_packed(p_archetype) ? p_archetype.get_rows_per_chunk() : 1;
+			while (p_first_row < p_last_row)
+			{
+				const std::size_t chunk_end = std::min(p_last_row, (p_first_row / rows_per_chunk + 1) * rows_per_chunk);
+				_process_rows(p_archetype, p_first_row, chunk_end - p_first_row, p_worker, typename MakeIndexSequence<sizeof...(components_t)>::type());
+				p_first_row = chunk_end;
+			}
+		}
+
+	protected:
+		//! \brief Registers the component types, derived classes overriding it must call it
+		void on_added() override
+		{
+			_register<components_t...>();
+		}
+
+	private:
+		template <typename component_t, typename ...others_t>
+		void _register()
+		{
+			typedef typename std::remove_const<component_t>::type type_t;
+
+			// Registering first with packed columns, spans step by sizeof(type_t)
+			register_component<type_t>(std::alignment_of<type_t>::value);
+			assert(!is_component_split<type_t>());
+			if (std::is_const<component_t>::value)
+				read_component<type_t>();
+			else
+				write_component<type_t>();
+
+			m_types[sizeof...(components_t) - sizeof...(others_t) - 1] = get_component_type<type_t>();
+			_register<others_t...>();
+		}
+
+		template <int = 0>
+		void _register() { }
+
+		template <std::size_t ...indices>
+		void _process_entity(Entity& p_entity, std::size_t p_worker, IndexSequence<indices...>)
+		{
+			process_batch(p_worker, Span<components_t>(static_cast<components_t*>(p_entity.get_component_ptr(m_types[indices])), 1)...);
+		}
+
+		template <std::size_t ...indices>
+		void _process_rows(Archetype& p_archetype, std::size_t p_row, std::size_t p_count, std::size_t p_worker, IndexSequence<indices...>)
+		{
+			process_batch(p_worker, Span<components_t>(_column<components_t>(p_archetype, p_row, m_types[indices]), p_count)...);
+		}
+
+		template <typename component_t>
+		static component_t* _column(Archetype& p_archetype, std::size_t p_row, Component::type_t p_type)
+		{
+			return reinterpret_cast<component_t*>(p_archetype.get_element_ptr(p_row, p_type));
+		}
+
+		// True if the columns of all the types are arrays, not over-aligned
+		bool _is_packed(const Archetype& p_archetype)const
+		{
+			const std::size_t sizes[] = { sizeof(components_t)... };
+			for (std::size_t i = 0; i < sizeof...(components_t); ++i)
+			{
+				if (p_archetype.get_column_stride(m_types[i]) != sizes[i])
+					return false;
+			}
+			return true;
+		}
+
+	private:
+		Component::type_t m_types[sizeof...(components_t)];
+	};
+}
\ No newline at end of file
@@ -0,0 +1,212 @@
+//! \copyright Mozilla Public License Version 2.0
+//! \note [License]		 license/license.txt
+//! \note [Contributors] license/contributors.txt
+
+#pragma once
+
+// C++ STD
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+#include <tuple>
+#include <utility>
+#include <type_traits>
+#include <new>
+
+// ssa
+#include "ssa_entity_id.hpp"
+#include "ssa_entity_handle.hpp"
+#include "ssa_component_factory.hpp"
+#include "../core/ssa_frame_arena.hpp"
+#include "../core/ssa_type_index.hpp"
+#include "../core/ssa_index_sequence.hpp"
+
+namespace ssa
+{
+	// Forward declaration
+	class EntityFactory;
+
+	//! \brief Records structural changes ( creating / removing entities, attaching / detaching components ) to apply them
+	//!		later, when no system is iterating the pools. 
+	//!
+	//! A buffer is meant to be used by one thread at a time, the SystemLooper gives every worker its own 
+	//!	( System::get_commands() ) and plays them back at the end of every stage. Constructor arguments of attached
+	//!	components are stored in the buffer until then. Commands on an entity removed meanwhile are ignored
+	class ssa_export CommandBuffer
+	{
+	public:
+		//! \brief Entity created by the buffer, only valid as target of the commands of the same buffer until playback
+		struct DeferredEntity
+		{
+			std::uint32_t index;
+		};
+
+	public:
+		//! \param [in] p_allocator Source of the memory holding the constructor arguments, must outlive the buffer
+		CommandBuffer(Allocator& p_allocator = get_default_allocator());
+
+		//! \brief Discards the commands not played back
+		~CommandBuffer();
+
+		CommandBuffer(const CommandBuffer&) = delete;
+		CommandBuffer& operator=(const CommandBuffer&) = delete;
+
+		//! \brief Records the creation of an entity, other commands can target it through the returned value
+		DeferredEntity create();
+
+		void destroy(EntityId p_entity);
+		void destroy(DeferredEntity p_entity);
+
+		//! \brief Records the attaching of a component, the arguments are copied / moved into the buffer
+		template <typename component_t, typename ...ctor_args_t>
+		void attach(EntityId p_entity, ctor_args_t&& ...p_args);
+
+		template <typename component_t, typename ...ctor_args_t>
+		void attach(DeferredEntity p_entity, ctor_args_t&& ...p_args);
+
+		template <typename component_t>
+		void detach(EntityId p_entity);
+
+		template <typename component_t>
+		void detach(DeferredEntity p_entity);
+
+		bool empty()const { return m_commands.empty(); }
+		std::size_t get_size()const { return m_commands.size(); }
+
+		//! \brief Applies the commands in the order they were recorded and empties the buffer. Pools are grown once
+		//!		for all the entities and components the buffer creates. Must not run while systems are iterating
+		void playback(EntityFactory& p_entity_factory, ComponentFactory& p_component_factory);
+
+		//! \brief Discards all the commands
+		void clear();
+
+	private:
+		enum class CommandType : std::uint8_t
+		{
+			Create,
+			Destroy,
+			Attach,
+			Detach
+		};
+
+		// Attaches / detaches the component, p_payload holds the constructor arguments
+		typedef void(*apply_t)(ComponentFactory& p_component_factory, EntityHandle& p_entity, void* p_payload);
+		typedef void(*destroy_t)(void* p_payload);
+		typedef void(*reserve_t)(ComponentFactory& p_component_factory, std::size_t p_count);
+
+		struct Command
+		{
+			CommandType	type;
+			bool		deferred;	// target.index is a DeferredEntity
+			EntityId	target;
+			apply_t		apply;
+			destroy_t	destroy;
+			void*		payload;
+		};
+
+		// Number of components of a type created by the buffer
+		struct Reservation
+		{
+			std::size_t	type_index;	// TypeIndex<Component>
+			std::size_t	count;
+			reserve_t	reserve;
+		};
+
+		void _push(CommandType p_type, EntityId p_target, bool p_deferred, apply_t p_apply = nullptr, 
+			destroy_t p_destroy = nullptr, void* p_payload = nullptr);
+
+		static EntityId _deferred_target(DeferredEntity p_entity);
+
+		template <typename component_t, typename ...ctor_args_t>
+		void _attach(EntityId p_target, bool p_deferred, ctor_args_t&& ...p_args);
+
+		template <typename component_t, typename args_t, std::size_t ...indices>
+		static void _construct(ComponentFactory& p_component_factory, EntityHandle& p_entity, args_t& p_args, IndexSequence<indices...>)
+		{
+			p_component_factory.attach_component<component_t>(p_entity, std::move(std::get<indices>(p_args))...);
+		}
+
+		template <typename component_t, typename args_t>
+		static void _apply_attach(ComponentFactory& p_component_factory, EntityHandle& p_entity, void* p_payload)
+		{
+			_construct<component_t>(p_component_factory, p_entity, *static_cast<args_t*>(p_payload), 
+				typename MakeIndexSequence<std::tuple_size<args_t>::value>::type());
+		}
+
+		template <typename args_t>
+		static void _destroy_payload(void* p_payload)
+		{
+			static_cast<args_t*>(p_payload)->~args_t();
+		}
+
+		template <typename component_t>
+		static void _apply_detach(ComponentFactory& p_component_factory, EntityHandle& p_entity, void*)
+		{
+			p_component_factory.detach_component<component_t>(p_entity);
+		}
+
+		template <typename component_t>
+		static void _reserve(ComponentFactory& p_component_factory, std::size_t p_count)
+		{
+			p_component_factory.reserve_components<component_t>(p_count);
+		}
+
+	private:
+		std::vector<Command>		m_commands;
+		std::vector<Reservation>	m_reservations;
+		std::vector<EntityId>		m_created;		// Entities created by the playback, indexed by DeferredEntity
+		std::uint32_t				m_create_count;
+		FrameArena					m_payloads;
+	};
+
+	template <typename component_t, typename ...ctor_args_t>
+	void CommandBuffer::attach(EntityId p_entity, ctor_args_t&& ...p_args)
+	{
+		_attach<component_t>(p_entity, false, std::forward<ctor_args_t>(p_args)...);
+	}
+
+	template <typename component_t, typename ...ctor_args_t>
+	void CommandBuffer::attach(DeferredEntity p_entity, ctor_args_t&& ...p_args)
+	{
+		_attach<component_t>(_deferred_target(p_entity), true, std::forward<ctor_args_t>(p_args)...);
+	}
+
+	template <typename component_t>
+	void CommandBuffer::detach(EntityId p_entity)
+	{
+		_push(CommandType::Detach, p_entity, false, &_apply_detach<component_t>);
+	}
+
+	template <typename component_t>
+	void CommandBuffer::detach(DeferredEntity p_entity)
+	{
+		_push(CommandType::Detach, _deferred_target(p_entity), true, &_apply_detach<component_t>);
+	}
+
+	template <typename component_t, typename ...ctor_args_t>
+	void CommandBuffer::_attach(EntityId p_target, bool p_deferred, ctor_args_t&& ...p_args)
+	{
+		typedef std::tuple<typename std::decay<ctor_args_t>::type...> args_t;
+
+		void* payload = m_payloads.allocate(sizeof(args_t), std::alignment_of<args_t>::value);
+		new (payload) args_t(std::forward<ctor_args_t>(p_args)...);
+		_push(CommandType::Attach, p_target, p_deferred, &_apply_attach<component_t, args_t>, &_destroy_payload<args_t>, payload);
+
+		// Counting the components of the type to grow its pool once
+		const std::size_t type_index = TypeIndex<Component>::get<component_t>();
+		for (auto& reservation : m_reservations)
+		{
+			if (reservation.type_index == type_index)
+			{
+				++reservation.count;
+				return;
+			}
+		}
+
+		Reservation reservation;
+		reservation.type_index = type_index;
+		reservation.count = 1;
+		reservation.reserve = &_reserve<component_t>;
+		m_reservations.push_back(reservation);
+	}
+}
\ No newline at end of file
@@ -6,10 +6,10 @@
 
 // C++ STD
 #include <cstdint>
-#include <bitset>
 
 // ssa
 #include "../core/ssa_platform.hpp"
+#include "ssa_signature.hpp"
 
 namespace ssa
 {
@@ -19,14 +19,20 @@ namespace ssa
 	class ssa_export Component
 	{
 		friend class ComponentFactory;
+		friend class EntityFactory;
+		friend class Archetype;
+		friend class EntityHandle;
 	public:
-		const static std::uint64_t max_component_number{ 42 };
+		const static std::uint64_t max_component_number{ ssa_max_components };
 
 		typedef std::uint64_t id_t;
 		typedef std::uint64_t type_t;
 
+		//! \brief Set of component types, one bit per type ( see ssa_signature.hpp )
+		typedef Signature signature_t;
+
 	public:
-		Component() : m_type{ 0 }, m_entity{ nullptr }, m_id{ 0 } { } 
+		Component() : m_type{ 0 }, m_entity{ nullptr }, m_id{ 0 }, m_version{ 0 } { } 
 
 		// TODO ? dobbiamo togliere il link quando va out of scope ?
 		~Component() = default;
@@ -35,6 +41,13 @@ namespace ssa
 		Entity* get_entity()const { return m_entity; }
 		id_t get_id()const { return m_id; }
 
+		//! \brief Returns the change tick of the last attach / modification ( see ComponentFactory::get_change_tick() )
+		std::uint32_t get_version()const { return m_version; }
+
+		//! \brief True if the component has been attached or modified at or after the tick. Ticks wrap around, the 
+		//!		comparison holds as long as they are less than 2^31 apart
+		bool is_changed_since(std::uint32_t p_tick)const { return static_cast<std::int32_t>(m_version - p_tick) >= 0; }
+
 	private:
 		// Type of the component, can range from 0 to MAX_COMPONENT_NUMBER
 		type_t  m_type;
@@ -42,6 +55,10 @@ namespace ssa
 		// Entity the Component is linked to 
 		Entity* m_entity;
 
+		// Index in the component's pool, or row in its table in archetype mode
 		id_t	m_id;
+
+		// Change tick of the last attach / modification
+		std::uint32_t m_version;
 	};
 }
\ No newline at end of file
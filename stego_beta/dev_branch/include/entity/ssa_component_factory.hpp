@@ -6,33 +6,114 @@
 
 // C++ STD
 #include <cstdlib>
-#include <array>
+#include <vector>
 #include <unordered_map>
+#include <utility>
+#include <string>
+#include <typeinfo>
+#include <type_traits>
+#include <algorithm>
+#include <new>
+#include <cassert>
+#include <atomic>
 
 // ssa
 #include "ssa_component.hpp"
 #include "ssa_entity_handle.hpp"
-#include "../core/ssa_bag.hpp"
+#include "ssa_archetype.hpp"
+#include "ssa_signature.hpp"
+#include "ssa_entity_observer.hpp"
+#include "../core/ssa_typed_bag.hpp"
+#include "../core/ssa_pool_stats.hpp"
+#include "../core/ssa_type_index.hpp"
 
 namespace ssa
 {
+	// Forward declaration
+	class EntityFactory;
+	class Prefab;
+
 	//! \brief Class that manages registration / creation of components and their linking to entities
-	class ssa_export ComponentFactory
+	//!
+	//! Components can be stored in two ways ( StorageMode ), chosen before the first type is registered:
+	//!	- Pools: every component type has its own Bag, the components of an entity are scattered across the bags
+	//!	- Archetypes: entities with the same set of component types share a table ( Archetype ) where every type has 
+	//!		its own column, attaching / detaching moves the entity to another table. Systems touching a few types stream 
+	//!		through the columns. Components can't be attached / detached while the tables are being iterated
+	//!
+	//! Removing a component is O(1) in both modes: its slot goes back to the bag's free list, or the last row of the table 
+	//!	is swapped into the hole. Added as observer of the EntityFactory the factory destroys the components of the removed
+	//!	entities
+	class ssa_export ComponentFactory : public EntityObserver
 	{
-		typedef std::size_t type_hash_t;
+	public:
+		enum class StorageMode
+		{
+			Pools,		// One Bag per component type
+			Archetypes	// One table per set of component types
+		};
+
 	public:
 		//! \brief Creates a new instance of the class, but does not allocate memory till components are registered
-		ComponentFactory();
+		//! \param [in] p_allocator Source of the memory of all the component pools, must outlive the factory
+		ComponentFactory(Allocator& p_allocator = get_default_allocator());
 
-		//! \brief Deallocates and unlinks all the components
+		//! \brief Destroys all the components and deallocates their pools
 		~ComponentFactory();
 
-		//! \brief Constructs a component from the parameters and attaches it to the specified entity
+		//! \brief Sets how components are stored, must be called before any component type is registered
+		void set_storage_mode(StorageMode p_mode);
+		StorageMode get_storage_mode()const { return m_storage_mode; }
+
+		//! \brief Enables / disables concurrent attaching of components from multiple threads for all the pools.
+		//!		When enabled every component type must be registered before threads start attaching. Pools mode only
+		void set_concurrent(bool p_concurrent);
+		bool is_concurrent()const { return m_concurrent; }
+
+		//! \brief Registers a new component type and creates its pool, does nothing if already registered.
+		//!		Called with default parameters by attach_component() the first time a type is attached. In archetype mode 
+		//!		there are no pools, the alignment is used for the type's columns and the capacity is ignored
+		//! \param [in] p_alignment Alignment of every component in the pool ( power of two ), the component's own alignment 
+		//!		is used if higher. 16 / 32 allow aligned SSE / AVX loads, 64 puts every component on its own cache line(s).
+		//!		By default components are packed at their own alignment
+		//! \param [in] p_initial_capacity Number of components the pool can hold before growing
+		//! \return Type ( index ) of the component
+		template <typename component_t>
+		Component::type_t register_component(std::size_t p_alignment = natural_alignment, std::size_t p_initial_capacity = 10);
+
+		//! \brief Registers a trivially copyable component type whose fields are stored as structure of arrays in archetype 
+		//!		mode: every listed member gets its own column of tightly packed values, systems read them as parallel spans 
+		//!		( Archetype::get_field_span(), System::get_field_span() ) ready to be vectorized. Members not listed are not 
+		//!		stored. Entities reach the fields through EntityHandle::get_field(), get_component() must not be used.
+		//!		In pools mode the type is registered as a whole component
+		//! \param [in] p_alignment Alignment of every field column, 16 / 32 allow aligned SSE / AVX loads
+		//! \param [in] p_fields Members of the component stored, at most max_component_fields
+		//! \return Type ( index ) of the component
+		template <typename component_t, typename ...fields_t>
+		Component::type_t register_soa_component(std::size_t p_alignment, fields_t component_t::* ...p_fields);
+
+		//! \brief True if the fields of the type are stored in their own columns ( see register_soa_component() )
+		bool is_split(Component::type_t p_type)const
+		{
+			return m_storage_mode == StorageMode::Archetypes && m_layouts[static_cast<std::size_t>(p_type)].field_count != 0;
+		}
+
+		//! \brief Returns the index of the field at the offset in the layout of a split type, max_component_fields if not stored
+		std::size_t get_field_index(Component::type_t p_type, std::size_t p_offset)const;
+
+		//! \brief Returns a member of the entity's component, wherever it is stored
+		template <typename component_t, typename field_t>
+		field_t& get_field(Entity& p_entity, field_t component_t::* p_field);
+
+		//! \brief Constructs a component in place from the parameters and attaches it to the specified entity
 		//! \param [in] p_entity_handle Handle of the entity the component will be attached to 
-		//! \param [in] p_args Constructor arguments for the component
+		//! \param [in] p_args Constructor arguments for the component, perfectly forwarded
+		//! \return Id of the component, in archetype mode it is the row in the table and changes when the table changes
 		template <typename component_t, typename ...ctor_args>
-		Component::id_t attach_component(EntityHandle& p_entity_handle, ctor_args ...p_args);
+		Component::id_t attach_component(EntityHandle& p_entity_handle, ctor_args&& ...p_args);
 
+		//! \brief Returns the component with the specified id from its pool. Pools mode only, in archetype mode components are 
+		//!		reached through their entity
 		template <typename component_t>
 		component_t& get_component(Component::id_t p_id);
 
@@ -41,67 +122,313 @@ namespace ssa
 		template <typename component_t>
 		void detach_component(EntityHandle& p_entity_handle);
 
-		//! \brief Retrieves the internal buffer of components of the specified type ( user should not use this for any reason 
+		//! \brief Attaches a copy of every component of the prefab to each entity, the entities must have no components. 
+		//!		Every pool grows once, in archetype mode the rows are appended to a single table and filled column by column
+		void instantiate(const Prefab& p_prefab, Entity* const* p_entities, std::size_t p_count);
+
+		//! \brief Detaches and destroys all the components of the specified entity, in archetype mode the entity leaves
+		//!		its table in a single row removal
+		void detach_all(EntityHandle& p_entity_handle) { _detach_all(p_entity_handle.get()); }
+
+		//! \brief Moves the components of every type to the front of their pool and releases unused pages, 
+		//!		entities are patched to point to the new locations ( component ids change )
+		void compact();
+
+		//! \brief Writes the type registry and every component pool to the stream as raw bytes, every registered
+		//!		component type must be trivially copyable
+		//! \return False if a type is not trivially copyable or writing failed
+		bool write_snapshot(std::ostream& p_stream)const;
+
+		//! \brief Replaces all the components with the ones in the snapshot and links them to the entities restored by
+		//!		EntityFactory::read_snapshot(). The types in the snapshot must already be registered, they are matched by 
+		//!		name and can have a different index. Pools of registered types not in the snapshot are emptied
+		//! \param [in] p_entity_factory Factory the entities have been restored into
+		//! \param [in] p_entity_layout Layout returned by EntityFactory::read_snapshot()
+		//! \return False if the registry does not match or reading failed
+		bool read_snapshot(std::istream& p_stream, EntityFactory& p_entity_factory, const Bag::SnapshotLayout& p_entity_layout);
+
+		//! \brief Appends the stats of every component pool to the list, pools are named after the component type
+		void get_pool_stats(pool_stats_list_t& p_stats)const;
+
+		//! \brief Adds an observer notified when components are attached / detached, it must outlive the factory or be removed before
+		void add_observer(EntityObserver* p_observer) { m_observers.push_back(p_observer); }
+		void remove_observer(EntityObserver* p_observer);
+
+		//! \brief Calls p_func(Archetype&) for every table whose signature contains all the types in p_required
+		template <typename func_t>
+		void for_each_archetype(const Archetype::signature_t& p_required, func_t p_func);
+
+		//! \brief Retrieves the internal buffer of components of the specified type, pools mode only ( user should not use this for any reason 
 		//! \param [in] p_type DON'T CALL THIS METHOD
 		//! \return DON'T CALL THIS METHOD
 		Bag& get_components_all(Component::type_t p_type) { return *m_components[static_cast<std::size_t>(p_type)]; }
 
+		//! \brief Registers the type if needed and makes room for p_count more components of the type, pools mode only
+		//!		( tables grow a chunk at a time )
+		template <typename component_t>
+		void reserve_components(std::size_t p_count);
+
+		//! \brief Returns the current change tick. Attached and modified components are stamped with it ( Component::get_version() )
+		std::uint32_t get_change_tick()const { return m_change_tick.load(std::memory_order_relaxed); }
+
+		//! \brief Starts a new change tick and returns it, the SystemLooper advances it before running every system
+		std::uint32_t advance_change_tick() { return m_change_tick.fetch_add(1, std::memory_order_relaxed) + 1; }
+
+		//! \brief Stamps the component with the current tick, for writes that do not go through EntityHandle::modify_component()
+		void mark_changed(Component& p_component)const { p_component.m_version = get_change_tick(); }
+
+		//! \brief Returns the number of live components of the specified type, in archetype mode the rows of the tables storing it
+		std::size_t get_live_count(Component::type_t p_type)const;
+
 		//! \brief Returns the type ( index ) from the actual type, returns Component::max_component + 1 if does not exists
 		template <typename component_t>
 		Component::type_t get_type_from_component()const;
 
+		// EntityObserver, only removals are of interest
+		void on_component_attached(Entity&, Component::type_t) override { }
+		void on_component_detached(Entity&, Component::type_t) override { }
+		void on_entity_removed(Entity& p_entity) override { _detach_all(p_entity); }
+
+	private:
+		// Returns the table for the signature, creating it if needed
+		Archetype& _get_archetype(const Archetype::signature_t& p_signature);
+
+		// Moves the entity into a new row of the table, returns the row
+		std::size_t _move_entity(Entity& p_entity, Archetype& p_archetype);
+
+		void _detach_component(Entity& p_entity, Component::type_t p_type);
+
+		void _detach_all(Entity& p_entity);
+
 	private:
-		std::array<Bag*, Component::max_component_number>	m_components;
-		std::unordered_map<type_hash_t, Component::type_t>	m_types;
+		std::vector<Bag*>									m_components;	// Indexed by type, grown on registration, null in archetype mode
+		std::vector<Component::type_t>						m_types;	// Indexed by TypeIndex<Component>, max_component_number + 1 if not registered
+		std::vector<std::string>							m_type_names;
 		std::size_t											m_last_type;
+		bool												m_concurrent;
+		Allocator*											m_allocator;
+
+		StorageMode											m_storage_mode;
+		std::vector<ComponentLayout>						m_layouts;
+		std::unordered_map<Archetype::signature_t, Archetype*, SignatureHash> m_archetype_map;
+		std::vector<Archetype*>								m_archetypes;
+
+		std::vector<EntityObserver*>						m_observers;
+		std::atomic<std::uint32_t>							m_change_tick;
 	};
 
+	template <typename component_t>
+	Component::type_t ComponentFactory::register_component(std::size_t p_alignment, std::size_t p_initial_capacity)
+	{
+		const Component::type_t registered = get_type_from_component<component_t>();
+		if (registered < Component::max_component_number)
+			return registered;
+
+		// The type register is not synchronized, types must be registered before attaching concurrently
+		assert(!m_concurrent);
+		assert(m_last_type < Component::max_component_number);
+
+		Component::type_t new_type = m_last_type++;
+		const std::size_t index = TypeIndex<Component>::get<component_t>();
+		if (index >= m_types.size())
+			m_types.resize(index + 1, Component::max_component_number + 1);
+		m_types[index] = new_type; // Adding it to type register
+		m_components.push_back(nullptr);
+		m_type_names.push_back(typeid(component_t).name());
+		m_layouts.push_back(ComponentLayout());
+
+		if (m_storage_mode == StorageMode::Archetypes)
+		{
+			ComponentLayout& layout = m_layouts[static_cast<std::size_t>(new_type)];
+			layout.size = sizeof(component_t);
+			layout.alignment = std::max<std::size_t>(p_alignment, std::alignment_of<component_t>::value);
+			layout.traits = TypedBag<component_t>::get_object_traits();
+			layout.field_count = 0;
+			layout.field_alignment = layout.alignment;
+			return new_type;
+		}
+
+		m_components[static_cast<std::size_t>(new_type)] = new TypedBag<component_t>(p_initial_capacity, Bag::default_page_size, p_alignment, *m_allocator); // Creating new bag
+		m_components[static_cast<std::size_t>(new_type)]->set_concurrent(m_concurrent);
+
+		return new_type;
+	}
+
+	template <typename component_t, typename ...fields_t>
+	Component::type_t ComponentFactory::register_soa_component(std::size_t p_alignment, fields_t component_t::* ...p_fields)
+	{
+		static_assert(std::is_trivially_copyable<component_t>::value, "Components stored as structure of arrays must be trivially copyable");
+		static_assert(sizeof...(fields_t) > 0 && sizeof...(fields_t) <= max_component_fields, "Too many or no fields");
+
+		const Component::type_t registered = get_type_from_component<component_t>();
+		if (registered < Component::max_component_number)
+			return registered;
+
+		const Component::type_t type = register_component<component_t>(p_alignment);
+		if (m_storage_mode != StorageMode::Archetypes)
+			return type;
+
+		const std::size_t offsets[] = { get_field_offset(p_fields)... };
+		const std::size_t sizes[] = { sizeof(fields_t)... };
+		const std::size_t alignments[] = { std::alignment_of<fields_t>::value... };
+
+		// The column keeps the headers, linking the entity as any other component
+		ComponentLayout& layout = m_layouts[static_cast<std::size_t>(type)];
+		layout.size = sizeof(Component);
+		layout.alignment = std::alignment_of<Component>::value;
+		layout.traits = TypedBag<Component>::get_object_traits();
+		layout.field_count = sizeof...(fields_t);
+		layout.field_alignment = p_alignment;
+		for (std::size_t field = 0; field < layout.field_count; ++field)
+		{
+			layout.fields[field].offset = offsets[field];
+			layout.fields[field].size = sizes[field];
+			layout.field_alignment = std::max(layout.field_alignment, alignments[field]);
+		}
+
+		return type;
+	}
+
+	template <typename component_t, typename field_t>
+	field_t& ComponentFactory::get_field(Entity& p_entity, field_t component_t::* p_field)
+	{
+		const Component::type_t type = get_type_from_component<component_t>();
+		assert(p_entity.has_component(type));
+
+		if (!is_split(type))
+			return static_cast<component_t*>(p_entity.get_component_ptr(type))->*p_field;
+
+		const std::size_t field = get_field_index(type, get_field_offset(p_field));
+		assert(field < max_component_fields);
+		return *reinterpret_cast<field_t*>(p_entity.m_archetype->get_field_ptr(p_entity.m_row, type, field));
+	}
+
 	template <typename component_t, typename ...ctor_args>
-	Component::id_t ComponentFactory::attach_component(EntityHandle& e, ctor_args ...p_args)
+	Component::id_t ComponentFactory::attach_component(EntityHandle& e, ctor_args&& ...p_args)
 	{
-		type_hash_t hash = typeid(component_t).hash_code();
-		auto find_res = m_types.find(hash);
-		Component::type_t new_type;
+		Component::type_t new_type = register_component<component_t>();
+		Entity& entity = e.get();
 
-		if (find_res == m_types.end()) // Type has not been registered yet
+		Component::id_t id;
+		Component* new_component;
+		if (m_storage_mode == StorageMode::Archetypes)
 		{
-			new_type = m_last_type++;
-			m_types[hash] = new_type; // Adding it to type register
-			m_components[static_cast<std::size_t>(new_type)] = new Bag(sizeof(component_t), 10); // Creating new bag
+			// Moving the entity to the table with one more column and constructing the component there
+			assert(!entity.has_component(new_type));
+			Archetype& archetype = _get_archetype(entity.get_signature() | signature_bit(new_type));
+			id = _move_entity(entity, archetype);
+			if (m_layouts[static_cast<std::size_t>(new_type)].field_count == 0)
+			{
+				new_component = new (archetype.get_element_ptr(static_cast<std::size_t>(id), new_type)) component_t(std::forward<ctor_args>(p_args)...);
+			}
+			else
+			{
+				// Only the header stays in the column, the fields go to their own columns
+				const component_t component(std::forward<ctor_args>(p_args)...);
+				new_component = new (archetype.get_element_ptr(static_cast<std::size_t>(id), new_type)) Component();
+				archetype.scatter_fields(static_cast<std::size_t>(id), new_type, &component);
+			}
 		}
 		else
-			new_type = find_res->second;
-
-		Component::id_t id = m_components[static_cast<std::size_t>(new_type)]->add_object<component_t>(p_args...);
-		Component& new_component = m_components[static_cast<std::size_t>(new_type)]->get_object<Component>(id);
+		{
+			auto& bag = static_cast<TypedBag<component_t>&>(*m_components[static_cast<std::size_t>(new_type)]);
+			id = bag.emplace(std::forward<ctor_args>(p_args)...);
+			new_component = &bag.get(id);
+		}
 
 		// Filling out component's informations
-		new_component.m_type = new_type;
-		new_component.m_id = id;
-		new_component.m_entity = &e.get();
+		new_component->m_type = new_type;
+		new_component->m_id = id;
+		new_component->m_entity = &entity;
+		new_component->m_version = get_change_tick();
+		entity.add_component(new_component, new_type);
+
+		for (auto observer : m_observers)
+			observer->on_component_attached(entity, new_type);
 
 		return id;
 	}
 
 
+	template <typename component_t>
+	void ComponentFactory::reserve_components(std::size_t p_count)
+	{
+		const Component::type_t type = register_component<component_t>();
+		if (m_storage_mode == StorageMode::Pools)
+			m_components[static_cast<std::size_t>(type)]->reserve(p_count);
+	}
+
 	template <typename component_t>
 	component_t& ComponentFactory::get_component(Component::id_t p_id)
 	{
-		return m_components[static_cast<std::size_t>(m_types[typeid(component_t).hash_code()])]->get_object<component_t>(p_id);
+		assert(m_storage_mode == StorageMode::Pools);
+		return static_cast<TypedBag<component_t>&>(*m_components[static_cast<std::size_t>(get_type_from_component<component_t>())]).get(p_id);
 	}
 
 	template <typename component_t>
 	void ComponentFactory::detach_component(EntityHandle& p_entity_handle)
 	{
-		// @TODO : implement
+		const Component::type_t type = get_type_from_component<component_t>();
+		if (type >= Component::max_component_number || !p_entity_handle.get().has_component(type))
+			return;
+
+		_detach_component(p_entity_handle.get(), type);
+	}
+
+	template <typename func_t>
+	void ComponentFactory::for_each_archetype(const Archetype::signature_t& p_required, func_t p_func)
+	{
+		for (auto archetype : m_archetypes)
+		{
+			if (signature_matches(archetype->get_signature(), p_required))
+				p_func(*archetype);
+		}
 	}
 
 	template <typename component_t>
 	Component::type_t ComponentFactory::get_type_from_component()const
 	{
-		auto find_res = m_types.find(typeid(component_t).hash_code());
-		if (find_res == m_types.end())
+		const std::size_t index = TypeIndex<Component>::get<component_t>();
+		if (index >= m_types.size())
 			return Component::max_component_number + 1;
-		return find_res->second;
+		return m_types[index];
+	}
+
+	// EntityHandle templates, defined here where ComponentFactory is complete
+	template <typename component_t>
+	component_t& EntityHandle::get_component()
+	{
+		const Component::type_t type = m_component_factory->get_type_from_component<component_t>();
+		assert(!m_component_factory->is_split(type));
+		return m_entity->get_component<component_t>(type);
+	}
+
+	template <typename component_t, typename field_t>
+	field_t& EntityHandle::get_field(field_t component_t::* p_field)
+	{
+		return m_component_factory->get_field(*m_entity, p_field);
+	}
+
+	template <typename component_t, typename field_t>
+	field_t& EntityHandle::modify_field(field_t component_t::* p_field)
+	{
+		Component* component = m_entity->get_component_ptr(m_component_factory->get_type_from_component<component_t>());
+		component->m_version = m_component_factory->get_change_tick();
+		return m_component_factory->get_field(*m_entity, p_field);
+	}
+
+	template <typename component_t>
+	component_t& EntityHandle::modify_component()
+	{
+		component_t& component = get_component<component_t>();
+		component.m_version = m_component_factory->get_change_tick();
+		return component;
+	}
+
+	template <typename component_t, typename ...ctor_args_t>
+	void EntityHandle::attach_component(ctor_args_t&& ...p_ctor_args)
+	{
+		// The factory links the new component to the entity
+		m_component_factory->attach_component<component_t>(*this, std::forward<ctor_args_t>(p_ctor_args)...);
 	}
 }
\ No newline at end of file
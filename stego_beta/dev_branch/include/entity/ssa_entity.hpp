@@ -6,6 +6,7 @@
 
 // ssa
 #include "ssa_component.hpp"
+#include "../core/ssa_allocator.hpp"
 
 // C++ STD
 #include <cstdint>
@@ -13,32 +14,88 @@
 
 namespace ssa
 {
-	//! \brief 
+	// Forward declaration
+	class Archetype;
+
+	//! \brief Object of the game world, a slot in the EntityFactory linked to the components attached to it
+	//!
+	//! Components are stored in type order, the slot of a type is the number of types in the signature lower than it. 
+	//!	The first inline_components are kept in the entity, entities with more move all the pointers to a block from the
+	//! allocator of the EntityFactory, released when the entity is removed
 	class ssa_export Entity
 	{
+		friend class ComponentFactory;
+		friend class EntityFactory;
+		friend class Archetype;
 	public:
 		typedef std::uint64_t id_t;
 
+		//! \brief Number of components an entity can have before allocating
+		static const std::size_t inline_components{ 8 };
+
 		Entity();
 		~Entity();
 
 		template <typename component_t>
 		component_t& get_component(Component::type_t p_type);
 
+		//! \brief Returns the component of the specified type, nullptr if not attached
+		Component* get_component_ptr(Component::type_t p_type)
+		{
+			const std::size_t type = static_cast<std::size_t>(p_type);
+			return m_signature.test(type) ? _get_slots()[m_signature.rank(type)] : nullptr;
+		}
+
+		//! \brief Links / replaces the component of the specified type, unlinks it if c is null
 		void add_component(Component* c, Component::type_t type);
 
 		bool has_component(Component::type_t type);
 
-		std::uint64_t ref_count;
+		//! \brief Returns the set of attached component types, kept in sync by add_component
+		const Component::signature_t& get_signature()const { return m_signature; }
+
+		//! \brief Returns the number of attached components
+		std::size_t get_component_count()const { return m_component_count; }
+
+		//! \brief Calls p_func(Component*) for every attached component in type order
+		template <typename func_t>
+		void for_each_component(func_t p_func);
+
 		id_t id;
 
 	private:
-		Component* m_components[Component::max_component_number];
+		Component** _get_slots() { return m_overflow != nullptr ? m_overflow : m_inline; }
+
+		// Deallocates the overflow block and unlinks all the components, entities live in a raw Bag and are never destroyed
+		void _release();
+
+		// Drops the component links without deallocating, the overflow pointer of an entity read from a snapshot is stale
+		void _reset(Allocator& p_allocator);
+
+	private:
+		Component*				m_inline[inline_components];
+		Component**				m_overflow;			// Null while the components fit in m_inline
+		std::uint32_t			m_component_count;
+		std::uint32_t			m_overflow_capacity;
+		Allocator*				m_allocator;		// Source of the overflow block, set by the EntityFactory
+		Component::signature_t	m_signature;
+
+		// Table and row holding the components in archetype mode ( see ComponentFactory::StorageMode ), null if none
+		Archetype*	m_archetype;
+		std::size_t	m_row;
 	};
 
 	template <typename component_t>
 	component_t& Entity::get_component(Component::type_t p_type)
 	{
-		return *(static_cast<component_t*>(m_components[static_cast<std::size_t>(p_type)]));
+		return *(static_cast<component_t*>(get_component_ptr(p_type)));
+	}
+
+	template <typename func_t>
+	void Entity::for_each_component(func_t p_func)
+	{
+		Component** slots = _get_slots();
+		for (std::size_t i = 0; i < m_component_count; ++i)
+			p_func(slots[i]);
 	}
 }
\ No newline at end of file
@@ -6,8 +6,16 @@
 
 // ssa
 #include "ssa_entity.hpp"
+#include "ssa_entity_id.hpp"
 #include "../core/ssa_bag.hpp"
 #include "ssa_entity_handle.hpp"
+#include "ssa_entity_observer.hpp"
+
+// C++ STD
+#include <vector>
+#include <atomic>
+#include <memory>
+#include <mutex>
 
 namespace ssa
 {
@@ -15,27 +23,91 @@ namespace ssa
 	class EntityHandle;
 
 	//! \brief Class that manages, creation / destruction of handles and garbage collection
+	//!
+	//! Every slot of the pool has a generation, incremented when its entity is removed, EntityId pairs the slot with
+	//! the generation to detect removed entities. Generations are stored in pages that never move, validating an
+	//!	id is safe while other threads create entities
 	class ssa_export EntityFactory
 	{
 	public:
+		//! \brief Maximum number of entities alive at the same time
+		static const std::size_t max_entities{ 1 << 28 };
+
 		//! \brief Creates a new instance and allocates a pool of entities
-		EntityFactory();
+		//! \param [in] p_allocator Source of the memory of the entity pool, must outlive the factory
+		EntityFactory(Allocator& p_allocator = get_default_allocator());
 
 		// @TODO : DESTROY ALL ENTITIES
 		//! \brief Destructs all the associated entities
-		~EntityFactory() = default;
+		~EntityFactory();
+
+		EntityFactory(const EntityFactory&) = delete;
+		EntityFactory& operator=(const EntityFactory&) = delete;
+
+		//! \brief Enables / disables concurrent creation of entities from multiple threads
+		void set_concurrent(bool p_concurrent) { m_entities.set_concurrent(p_concurrent); }
 
 		//! \brief Creates a new entity and returns a handle to it
 		Entity& create_entity();
 
+		//! \brief Makes room for p_count more entities
+		void reserve(std::size_t p_count) { m_entities.reserve(p_count); }
+
 		//! \brief Returns the entity with the specified ID
 		Entity& get_entity(Entity::id_t p_id);
 
-		//! \brief Removes an entity from the active pool and unlinks all the components
+		//! \brief True if the ID belongs to an entity that has not been removed
+		bool is_alive(Entity::id_t p_id)const { return m_entities.is_occupied(p_id); }
+
+		//! \brief Returns the generational id of a live entity
+		EntityId get_id(const Entity& p_entity)const;
+
+		//! \brief True if the entity the id was taken from has not been removed
+		bool is_valid(EntityId p_id)const;
+
+		//! \brief Returns the entity with the specified id, null if it has been removed
+		Entity* resolve(EntityId p_id);
+
+		//! \brief Adds an observer notified when entities are removed, it must outlive the factory or be removed before
+		void add_observer(EntityObserver* p_observer) { m_observers.push_back(p_observer); }
+		void remove_observer(EntityObserver* p_observer);
+
+		//! \brief Removes an entity from the active pool, handles and ids of the entity become invalid. Its components are 
+		//!		destroyed by the ComponentFactory if it observes this factory ( EntityFrameworkAPI links them )
 		void remove_entity(Entity& p_entity);
 
+		//! \brief Returns occupancy and memory usage of the entity pool
+		PoolStats get_stats()const { return m_entities.get_stats(); }
+
+		//! \brief Moves all the entities to the front of the pool and releases unused pages, components are patched
+		//!		to point to the moved entities. Entity ids change, no EntityHandle should be alive when calling this
+		void compact();
+
+		//! \brief Writes the entity pool to the stream as raw bytes, see Bag::write_snapshot()
+		bool write_snapshot(std::ostream& p_stream)const { return m_entities.write_snapshot(p_stream); }
+
+		//! \brief Replaces all the entities with the ones in the snapshot, entities keep their slots. Ids and handles taken 
+		//!		before the load become invalid. Links to the components are cleared, ComponentFactory::read_snapshot() restores them
+		//! \param [out] p_layout Filled with the addresses the entities had when saved, needed to relink the components
+		bool read_snapshot(std::istream& p_stream, Bag::SnapshotLayout& p_layout);
+
 	private:
-		Bag m_entities;
+		// Returns the generation of the slot, p_index must have been used by an entity
+		std::atomic<std::uint32_t>& _generation(Entity::id_t p_index)const;
+
+		// Allocates the page of generations holding the slot if needed
+		void _reserve_generation(Entity::id_t p_index);
+
+	private:
+		static const std::size_t generation_page_size{ 16 * 1024 };
+		static const std::size_t max_generation_pages{ max_entities / generation_page_size };
+
+		Bag							m_entities;
+		std::vector<EntityObserver*> m_observers;
+
+		// Fixed directory of pages, allocated on demand and never moved
+		std::unique_ptr<std::atomic<std::atomic<std::uint32_t>*>[]> m_generation_pages;
+		std::mutex					m_generation_mutex;
 	};
 
 }
\ No newline at end of file
@@ -5,10 +5,17 @@
 #pragma once
 
 #include "ssa_entity.hpp"
+#include "ssa_entity_id.hpp"
 #include "ssa_entity_handle.hpp"
 #include "ssa_entity_factory.hpp"
+#include "ssa_entity_observer.hpp"
 #include "ssa_component.hpp"
+#include "ssa_archetype.hpp"
+#include "ssa_signature.hpp"
 #include "ssa_component_factory.hpp"
+#include "ssa_command_buffer.hpp"
+#include "ssa_prefab.hpp"
 #include "ssa_system.hpp"
+#include "ssa_batch_system.hpp"
 #include "ssa_system_looper.hpp"
 #include "ssa_entity_framework_api.hpp"
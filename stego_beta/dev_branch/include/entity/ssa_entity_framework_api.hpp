@@ -4,10 +4,16 @@
 
 #pragma once
 
+// C++ STD
+#include <istream>
+#include <ostream>
+#include <vector>
+
 // ssa
 #include "ssa_entity_factory.hpp"
 #include "ssa_component_factory.hpp"
 #include "ssa_system_looper.hpp"
+#include "ssa_prefab.hpp"
 
 namespace ssa
 {
@@ -17,25 +23,60 @@ namespace ssa
 	{
 	public:
 		//! \brief Constructs a new instance of the API and the sub-components [ all the allocation happens here ]
-		EntityFrameworkAPI();
+		//! \param [in] p_allocator Source of the memory of all the entity and component pools, must outlive the API
+		EntityFrameworkAPI(Allocator& p_allocator = get_default_allocator());
 
 		//! \brief Destructs all the subcomponents and deallocates all the memory
 		~EntityFrameworkAPI();
 
+		//! \brief Enables / disables concurrent creation of entities and attaching of components from multiple threads.
+		//!		Component types must be registered ( ComponentFactory::register_component() ) before enabling it,
+		//!		process() and compact() still have to be called while no other thread is spawning
+		void set_concurrent(bool p_concurrent);
+
+		//! \brief Returns the stats of the entity pool and of every component pool
+		pool_stats_list_t get_pool_stats()const;
+
+		//! \brief Writes the stats of all the pools, one line per pool
+		void dump_stats(std::ostream& p_stream)const;
+
 		// ===== ENTITY-RELATED METHODS =====
 		//! \brief Retrieves a new entity from the pool, this returns a fresh entity not linked to any components
 		//! \return Handle to the new entity
 		EntityHandle create_entity();
 
-		//! \brief Retrivies the handle from the entity ID ( user should not keep an entity ID around tho )
+		//! \brief Retrivies the handle from the entity ID, see EntityHandle::get_id()
 		//! \param [in] p_id Id of the entity
-		//! \return Handle to an already existing entity
-		EntityHandle get_entity(Entity::id_t p_id);
+		//! \return Handle to the entity, invalid if the entity has been removed
+		EntityHandle get_entity(EntityId p_id);
+
+		//! \brief Removes the entity, its handles and ids become invalid. Does nothing if it has already been removed
+		void remove_entity(EntityId p_id);
+
+		//! \brief Creates p_count entities with a copy of every component of the prefab. The entity pool and the component
+		//!		pools ( or the table ) are grown once, entities and components fill consecutive slots unless pools have holes
+		//! \param [out] p_ids If not null, the ids of the new entities are appended
+		void instantiate(const Prefab& p_prefab, std::size_t p_count, std::vector<EntityId>* p_ids = nullptr);
 
 		//! \brief Retrieves a reference to the internal factory used by the EntityFrameworkAPI
 		//! \return Reference to the factory
 		EntityFactory& get_entity_factory() { return m_entity_factory; }
 
+		//! \brief Defragments entities and components pools, live elements are moved to the front and unused pages 
+		//!		are released. Entity and component ids change, meant to be called between levels when no EntityHandle is alive
+		void compact();
+
+		//! \brief Writes all the entities and components to the stream as a raw memory dump. Every component type must be
+		//!		trivially copyable, the snapshot can only be loaded by the same build on the same platform. Pools storage mode only
+		//! \return False if a component type is not trivially copyable or writing failed
+		bool save_snapshot(std::ostream& p_stream)const;
+
+		//! \brief Replaces all the entities and components with the ones in the snapshot, pointers between them are relocated.
+		//!		Every component type in the snapshot must be registered ( in any order ) and no EntityHandle should be alive.
+		//!		If loading fails the content of the pools is undefined and should be discarded
+		//! \return False if the snapshot is not compatible or reading failed
+		bool load_snapshot(std::istream& p_stream);
+
 		// ===== COMPONENT-RELATED METHODS =====
 		//! \brief Retrieves a reference to the internal factory used by the EntityFrameworkAPI
 		//! \return Reference to the factory
@@ -65,6 +106,8 @@ namespace ssa
 		EntityFactory		m_entity_factory;
 		ComponentFactory	m_component_factory;
 		SystemLooper		m_system_looper;
+
+		std::vector<Entity*> m_instances;	// Scratch buffer of instantiate()
 	};
 
 	template <typename system_t, typename ...ctor_args_t>
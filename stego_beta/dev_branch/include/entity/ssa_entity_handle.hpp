@@ -4,48 +4,74 @@
 
 #pragma once
 
+// C++ STD
+#include <utility>
+#include <cassert>
+
 // ssa
 #include "ssa_component.hpp"
 #include "ssa_entity.hpp"
+#include "ssa_entity_id.hpp"
 
 namespace ssa
 {
 	// Forward declaration
 	class ComponentFactory;
+	class EntityFactory;
 
+	//! \brief Access to an entity and its components. Trivially copyable, it does not keep the entity alive: once the 
+	//!		entity is removed the handle becomes invalid ( is_valid() ), even if the slot is reused by another entity.
+	//!		Store get_id() to keep a reference around, it is smaller
 	class ssa_export EntityHandle
 	{
 	public:
-		EntityHandle(Entity& e, ComponentFactory& p_component_factory);
-		EntityHandle(const EntityHandle& p_other);
-		EntityHandle& operator=(const EntityHandle& p_other);
-		~EntityHandle();
+		//! \brief Invalid handle
+		EntityHandle();
+
+		//! \param [in] p_worker Index of the looper worker the handle is given to, see System::get_commands()
+		EntityHandle(Entity& p_entity, EntityFactory& p_entity_factory, ComponentFactory& p_component_factory, std::size_t p_worker = 0);
+
+		//! \brief False if the entity has been removed since the handle was created
+		bool is_valid()const;
+
+		Entity& get() 
+		{ 
+			assert(is_valid());
+			return *m_entity; 
+		}
 
-		Entity& get() { return *m_entity; }
+		EntityId get_id()const { return m_id; }
 
-		Entity::id_t get_id()const { return m_entity->id; }
+		//! \brief Returns the index of the looper worker processing the entity, 0 outside of the looper
+		std::size_t get_worker()const { return m_worker; }
 
 		template <typename component_t>
 		component_t& get_component();
 
+		//! \brief Returns a member of the component, the only way to reach the fields of a type stored as structure of 
+		//!		arrays ( ComponentFactory::register_soa_component() )
+		template <typename component_t, typename field_t>
+		field_t& get_field(field_t component_t::* p_field);
+
+		//! \brief Same as get_field() and marks the component as changed, see modify_component()
+		template <typename component_t, typename field_t>
+		field_t& modify_field(field_t component_t::* p_field);
+
+		//! \brief Returns the component and marks it as changed, the systems watching the type ( System::watch_component() )
+		//!		will receive the entity in their next run. get_component() does not track changes
+		template <typename component_t>
+		component_t& modify_component();
+
 		template <typename component_t, typename ...ctor_args_t>
-		void attach_component(ctor_args_t ...p_ctor_args);
+		void attach_component(ctor_args_t&& ...p_ctor_args);
 
 	private:
-		ComponentFactory*	m_component_factory;
 		Entity*				m_entity;
+		EntityFactory*		m_entity_factory;
+		ComponentFactory*	m_component_factory;
+		EntityId			m_id;
+		std::size_t			m_worker;
 	};
 
-	template <typename component_t>
-	component_t& EntityHandle::get_component()
-	{
-		return m_entity->get_component<component_t>(m_component_factory->get_type_from_component<component_t>());
-	}
-
-	template <typename component_t, typename ...ctor_args_t>
-	void EntityHandle::attach_component(ctor_args_t ...p_ctor_args)
-	{
-		Component::id_t new_component_id = m_component_factory->attach_component<component_t>(*this, p_ctor_args...);
-		m_entity->add_component(&m_component_factory->get_component<component_t>(new_component_id), m_component_factory->get_type_from_component<component_t>());
-	}
+	// Template members are defined in ssa_component_factory.hpp, they need the complete ComponentFactory
 }
\ No newline at end of file
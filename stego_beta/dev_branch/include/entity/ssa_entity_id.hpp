@@ -0,0 +1,45 @@
+//! \copyright Mozilla Public License Version 2.0
+//! \note [License]		 license/license.txt
+//! \note [Contributors] license/contributors.txt
+
+#pragma once
+
+// C++ STD
+#include <cstdint>
+
+namespace ssa
+{
+	//! \brief Identifies an entity across its whole life: index of its slot in the pool and generation of the slot, 
+	//!		incremented every time an entity in the slot is removed. An id whose generation does not match anymore 
+	//!		refers to a removed entity, even if the slot has been reused.
+	//!
+	//! Plain value, can be stored in containers and passed between threads. See EntityFactory::is_valid()
+	struct EntityId
+	{
+		std::uint32_t index;
+		std::uint32_t generation;
+
+		//! \brief Id never assigned to any entity
+		static EntityId invalid()
+		{
+			EntityId id;
+			id.index = ~static_cast<std::uint32_t>(0);
+			id.generation = 0;
+			return id;
+		}
+
+		//! \brief Packs index and generation in a single value, can be used as a key
+		std::uint64_t to_u64()const { return (static_cast<std::uint64_t>(generation) << 32) | index; }
+
+		static EntityId from_u64(std::uint64_t p_value)
+		{
+			EntityId id;
+			id.index = static_cast<std::uint32_t>(p_value & 0xffffffff);
+			id.generation = static_cast<std::uint32_t>(p_value >> 32);
+			return id;
+		}
+
+		bool operator==(const EntityId& p_other)const { return index == p_other.index && generation == p_other.generation; }
+		bool operator!=(const EntityId& p_other)const { return !(*this == p_other); }
+	};
+}
\ No newline at end of file
@@ -0,0 +1,31 @@
+//! \copyright Mozilla Public License Version 2.0
+//! \note [License]		 license/license.txt
+//! \note [Contributors] license/contributors.txt
+
+#pragma once
+
+// ssa
+#include "ssa_component.hpp"
+
+namespace ssa
+{
+	// Forward declaration
+	class Entity;
+
+	//! \brief Receives the structural changes of entities ( composition and lifetime ) from the factories.
+	//!		Callbacks run on the thread making the change, in concurrent mode they can run from multiple threads at once
+	class ssa_export EntityObserver
+	{
+	public:
+		virtual ~EntityObserver() { }
+
+		//! \brief Called after a component has been attached and linked to the entity
+		virtual void on_component_attached(Entity& p_entity, Component::type_t p_type) = 0;
+
+		//! \brief Called after a component has been detached and unlinked from the entity
+		virtual void on_component_detached(Entity& p_entity, Component::type_t p_type) = 0;
+
+		//! \brief Called right before the entity is returned to the pool
+		virtual void on_entity_removed(Entity& p_entity) = 0;
+	};
+}
\ No newline at end of file
@@ -0,0 +1,130 @@
+//! \copyright Mozilla Public License Version 2.0
+//! \note [License]		 license/license.txt
+//! \note [Contributors] license/contributors.txt
+
+#pragma once
+
+// C++ STD
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+#include <utility>
+#include <new>
+
+// ssa
+#include "ssa_component.hpp"
+#include "ssa_component_factory.hpp"
+#include "../core/ssa_typed_bag.hpp"
+#include "../core/ssa_type_index.hpp"
+
+namespace ssa
+{
+	//! \brief Set of components with their initial values, instantiated in bulk by EntityFrameworkAPI::instantiate().
+	//!		Every instance gets a copy of each component, the components must be copy-constructible
+	class ssa_export Prefab
+	{
+		friend class ComponentFactory;
+	public:
+		Prefab() { }
+
+		//! \brief Destroys the prototypes
+		~Prefab();
+
+		Prefab(const Prefab&) = delete;
+		Prefab& operator=(const Prefab&) = delete;
+
+		//! \brief Adds a component to the prefab, replacing the previous value if the type was already added
+		//! \param [in] p_args Constructor arguments of the prototype, perfectly forwarded
+		template <typename component_t, typename ...ctor_args>
+		Prefab& add(ctor_args&& ...p_args);
+
+		//! \brief Returns the prototype of the type, null if not in the prefab. Changes affect the next instances
+		template <typename component_t>
+		component_t* get();
+
+		std::size_t get_component_count()const { return m_entries.size(); }
+
+	private:
+		struct Entry
+		{
+			std::size_t	type_index;		// TypeIndex<Component>
+			Component*	prototype;
+
+			// Registers the type, returns its index in the factory
+			Component::type_t(*register_type)(ComponentFactory& p_factory);
+
+			// Copy-constructs p_count copies of the prototype p_stride bytes apart
+			void(*clone)(const Component& p_prototype, uint8_t* p_destination, std::size_t p_count, std::size_t p_stride);
+
+			// Copy-constructs the prototype in the first free spot of the pool
+			Component*(*emplace)(Bag& p_bag, const Component& p_prototype, Component::id_t& p_id);
+
+			void(*destroy)(Component* p_prototype);
+		};
+
+		template <typename component_t>
+		static Component::type_t _register(ComponentFactory& p_factory)
+		{
+			return p_factory.register_component<component_t>();
+		}
+
+		template <typename component_t>
+		static void _clone(const Component& p_prototype, uint8_t* p_destination, std::size_t p_count, std::size_t p_stride)
+		{
+			const component_t& prototype = static_cast<const component_t&>(p_prototype);
+			for (std::size_t i = 0; i < p_count; ++i, p_destination += p_stride)
+				new (p_destination) component_t(prototype);
+		}
+
+		template <typename component_t>
+		static Component* _emplace(Bag& p_bag, const Component& p_prototype, Component::id_t& p_id)
+		{
+			auto& bag = static_cast<TypedBag<component_t>&>(p_bag);
+			p_id = bag.emplace(static_cast<const component_t&>(p_prototype));
+			return &bag.get(p_id);
+		}
+
+		template <typename component_t>
+		static void _destroy(Component* p_prototype)
+		{
+			delete static_cast<component_t*>(p_prototype);
+		}
+
+		Entry* _find(std::size_t p_type_index);
+
+	private:
+		std::vector<Entry> m_entries;
+	};
+
+	template <typename component_t, typename ...ctor_args>
+	Prefab& Prefab::add(ctor_args&& ...p_args)
+	{
+		const std::size_t type_index = TypeIndex<Component>::get<component_t>();
+		component_t* prototype = new component_t(std::forward<ctor_args>(p_args)...);
+
+		Entry* entry = _find(type_index);
+		if (entry != nullptr)
+		{
+			entry->destroy(entry->prototype);
+			entry->prototype = prototype;
+			return *this;
+		}
+
+		Entry new_entry;
+		new_entry.type_index = type_index;
+		new_entry.prototype = prototype;
+		new_entry.register_type = &_register<component_t>;
+		new_entry.clone = &_clone<component_t>;
+		new_entry.emplace = &_emplace<component_t>;
+		new_entry.destroy = &_destroy<component_t>;
+		m_entries.push_back(new_entry);
+		return *this;
+	}
+
+	template <typename component_t>
+	component_t* Prefab::get()
+	{
+		Entry* entry = _find(TypeIndex<Component>::get<component_t>());
+		return entry != nullptr ? static_cast<component_t*>(entry->prototype) : nullptr;
+	}
+}
\ No newline at end of file
@@ -0,0 +1,215 @@
+//! \copyright Mozilla Public License Version 2.0
+//! \note [License]		 license/license.txt
+//! \note [Contributors] license/contributors.txt
+
+#pragma once
+
+// \brief Component signatures: one bit per component type, an entity matches a system if it has every bit the system has
+
+// C++ STD
+#include <cstdint>
+#include <cstddef>
+
+// ssa
+#include "../core/ssa_platform.hpp"
+#include "../core/ssa_bits.hpp"
+
+//! \brief Number of component types that can be registered, rounded up to a multiple of 64. Every 64 types add a word 
+//!		( 8 bytes ) to the signatures of entities, tables and systems, entities do not grow otherwise
+#if !defined(ssa_max_components)
+#define ssa_max_components 256
+#endif
+
+namespace ssa
+{
+	//! \brief Fixed-size set of component types stored as an array of 64-bit words
+	class Signature
+	{
+	public:
+		typedef std::uint64_t word_t;
+
+		static const std::size_t word_count{ (ssa_max_components + 63) / 64 };
+		static const std::size_t bit_count{ word_count * 64 };
+
+	public:
+		Signature() { clear(); }
+
+		//! \brief Returns the signature with only the bit of the specified type set
+		static Signature bit(std::size_t p_type)
+		{
+			Signature signature;
+			signature.set(p_type);
+			return signature;
+		}
+
+		void clear()
+		{
+			for (std::size_t w = 0; w < word_count; ++w)
+				m_words[w] = 0;
+		}
+
+		void set(std::size_t p_type) { m_words[p_type >> 6] |= _mask(p_type); }
+		void reset(std::size_t p_type) { m_words[p_type >> 6] &= ~_mask(p_type); }
+		void set(std::size_t p_type, bool p_value) { p_value ? set(p_type) : reset(p_type); }
+		bool test(std::size_t p_type)const { return (m_words[p_type >> 6] & _mask(p_type)) != 0; }
+
+		bool none()const
+		{
+			word_t bits = 0;
+			for (std::size_t w = 0; w < word_count; ++w)
+				bits |= m_words[w];
+			return bits == 0;
+		}
+
+		bool any()const { return !none(); }
+
+		//! \brief Returns the number of types in the set
+		std::size_t count()const
+		{
+			std::size_t count = 0;
+			for (std::size_t w = 0; w < word_count; ++w)
+				count += pop_count(m_words[w]);
+			return count;
+		}
+
+		//! \brief Returns the number of types in the set lower than p_type, the position of p_type among them
+		std::size_t rank(std::size_t p_type)const
+		{
+			const std::size_t word = p_type >> 6;
+			std::size_t rank = pop_count(m_words[word] & (_mask(p_type) - 1));
+			for (std::size_t w = 0; w < word; ++w)
+				rank += pop_count(m_words[w]);
+			return rank;
+		}
+
+		//! \brief True if every type in p_required is also in the set
+		bool contains(const Signature& p_required)const
+		{
+			word_t missing = 0;
+			for (std::size_t w = 0; w < word_count; ++w)
+				missing |= p_required.m_words[w] & ~m_words[w];
+			return missing == 0;
+		}
+
+		//! \brief True if the two sets have at least one type in common
+		bool intersects(const Signature& p_other)const
+		{
+			word_t common = 0;
+			for (std::size_t w = 0; w < word_count; ++w)
+				common |= p_other.m_words[w] & m_words[w];
+			return common != 0;
+		}
+
+		//! \brief Returns the first type in the set at or after p_type, bit_count if there are none
+		std::size_t find_next(std::size_t p_type)const
+		{
+			std::size_t word = p_type >> 6;
+			if (word >= word_count)
+				return bit_count;
+
+			word_t bits = m_words[word] & ~(_mask(p_type) - 1);
+			while (bits == 0)
+			{
+				if (++word == word_count)
+					return bit_count;
+				bits = m_words[word];
+			}
+			return (word << 6) + count_trailing_zeros(bits);
+		}
+
+		std::size_t find_first()const { return find_next(0); }
+
+		//! \brief Calls p_func(std::size_t) for every type in the set in ascending order, empty words are skipped
+		template <typename func_t>
+		void for_each(func_t p_func)const
+		{
+			for (std::size_t w = 0; w < word_count; ++w)
+			{
+				for (word_t bits = m_words[w]; bits != 0; bits &= bits - 1)
+					p_func((w << 6) + count_trailing_zeros(bits));
+			}
+		}
+
+		word_t get_word(std::size_t p_word)const { return m_words[p_word]; }
+
+		//! \brief Returns the word_count words, signatures in an array are contiguous words
+		const word_t* get_words()const { return m_words; }
+
+		std::size_t hash()const
+		{
+			// FNV-1a over the words
+			std::uint64_t hash = 14695981039346656037ull;
+			for (std::size_t w = 0; w < word_count; ++w)
+				hash = (hash ^ m_words[w]) * 1099511628211ull;
+			return static_cast<std::size_t>(hash);
+		}
+
+		Signature& operator|=(const Signature& p_other)
+		{
+			for (std::size_t w = 0; w < word_count; ++w)
+				m_words[w] |= p_other.m_words[w];
+			return *this;
+		}
+
+		Signature& operator&=(const Signature& p_other)
+		{
+			for (std::size_t w = 0; w < word_count; ++w)
+				m_words[w] &= p_other.m_words[w];
+			return *this;
+		}
+
+		Signature operator|(const Signature& p_other)const { Signature result(*this); return result |= p_other; }
+		Signature operator&(const Signature& p_other)const { Signature result(*this); return result &= p_other; }
+
+		Signature operator~()const
+		{
+			Signature result;
+			for (std::size_t w = 0; w < word_count; ++w)
+				result.m_words[w] = ~m_words[w];
+			return result;
+		}
+
+		bool operator==(const Signature& p_other)const
+		{
+			word_t different = 0;
+			for (std::size_t w = 0; w < word_count; ++w)
+				different |= m_words[w] ^ p_other.m_words[w];
+			return different == 0;
+		}
+
+		bool operator!=(const Signature& p_other)const { return !(*this == p_other); }
+
+	private:
+		static word_t _mask(std::size_t p_type) { return static_cast<word_t>(1) << (p_type & 63); }
+
+	private:
+		word_t m_words[word_count];
+	};
+
+	//! \brief Hasher of signatures, used as keys of the tables
+	struct SignatureHash
+	{
+		std::size_t operator()(const Signature& p_signature)const { return p_signature.hash(); }
+	};
+
+	//! \brief Returns the signature with only the bit of the specified type set
+	inline Signature signature_bit(std::size_t p_type)
+	{
+		return Signature::bit(p_type);
+	}
+
+	//! \brief True if every type in p_required is also in p_signature
+	inline bool signature_matches(const Signature& p_signature, const Signature& p_required)
+	{
+		return p_signature.contains(p_required);
+	}
+
+	//! \brief Tests a contiguous array of signatures against p_required. Only the words where p_required has bits are 
+	//!		tested. Where SSE2 is available the signatures are loaded from the array 128 bits at a time: two signatures 
+	//!		per instruction if they are a single word ( ssa_max_components <= 64 ), else two words of a signature when 
+	//!		p_required has bits in more than one word
+	//! \param [out] p_indices Receives the indices of the matching signatures in ascending order, must hold p_count elements
+	//! \return Number of matching signatures
+	ssa_export std::size_t filter_signatures(const Signature* p_signatures, std::size_t p_count, 
+		const Signature& p_required, std::uint64_t* p_indices);
+}
\ No newline at end of file
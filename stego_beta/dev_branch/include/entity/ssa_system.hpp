@@ -5,26 +5,37 @@
 #pragma once
 
 // C++ STD
-#include <bitset>
+#include <vector>
+#include <cstdint>
+#include <memory>
+#include <cassert>
 
 // C++ STD
 #include "ssa_component.hpp"
+#include "ssa_entity_handle.hpp"
+#include "ssa_archetype.hpp"
+#include "ssa_command_buffer.hpp"
 
 namespace ssa
 {
 	// Forward declarations
 	class EntityHandle;
+	class EntityFactory;
 	class ComponentFactory;
 
 	class ssa_export System
 	{
 		friend class SystemLooper;
 	public:
-		System() : m_enabled{ false } { } 
-		~System() = default;
+		System() : m_enabled{ false }, m_driver_type{ Component::max_component_number + 1 }, m_driver_size{ 0 }, m_matches_dirty{ true },
+			m_access_declared{ false }, m_chunk_size{ 0 }, m_worker_count{ 1 },
+			m_command_buffers{ nullptr }, m_worker{ 0 }, m_run_tick{ 0 }, m_last_run_tick{ 0 }, m_has_run{ false } { } 
+		virtual ~System() = default;
 
+		//! \brief Adds the type to the ones an entity needs to match, registering it in the ComponentFactory if needed
+		//! \param [in] p_alignment Alignment the type is registered with, see ComponentFactory::register_component()
 		template <typename component_t>
-		void register_component();
+		void register_component(std::size_t p_alignment = natural_alignment);
 
 		template <typename component_t>
 		void unregister_component();
@@ -32,41 +43,279 @@ namespace ssa
 		template <typename component_t>
 		bool is_component_registered();
 
-		bool is_component_registered(Component::id_t p_id)const { return m_registered_components[static_cast<std::size_t>(p_id)]; }
+		//! \brief Registers the component and restricts the matches to the entities whose component of the type has been 
+		//!		attached or modified ( EntityHandle::modify_component() ) since the previous run of the system, own changes 
+		//!		included. With more watched types an entity is processed if any of them changed. The first run processes all 
+		//!		the matches. In archetype chunked mode ranges of rows without changes are skipped
+		template <typename component_t>
+		void watch_component();
+
+		template <typename component_t>
+		void unwatch_component();
+
+		const Component::signature_t& get_watched_signature()const { return m_watched; }
+
+		//! \brief Returns the change tick the previous run started at, components changed since are at or after it
+		//!		( Component::is_changed_since() )
+		std::uint32_t get_last_run_tick()const { return m_last_run_tick; }
+
+		//! \brief Declares that process() reads components of the type. Systems reading the same types can run at the 
+		//!		same time ( see SystemLooper::set_worker_count() ), it does not change the matched entities
+		template <typename component_t>
+		void read_component();
+
+		//! \brief Declares that process() modifies components of the type, no other system accessing them runs at the same time
+		template <typename component_t>
+		void write_component();
+
+		//! \brief True if the system declared the types it accesses. Systems that did not are never run in parallel with
+		//!		other systems, the ones adding / removing entities or components should not declare them unless the factories
+		//!		are concurrent
+		bool has_declared_access()const { return m_access_declared; }
+
+		const Component::signature_t& get_read_signature()const { return m_reads; }
+		const Component::signature_t& get_write_signature()const { return m_writes; }
+
+		bool is_component_registered(Component::id_t p_id)const { return m_registered_components.test(static_cast<std::size_t>(p_id)); }
+
+		//! \brief Returns the ids of the entities matching the registered components as of the last process(), in no particular order
+		const std::vector<std::uint64_t>& get_matches()const { return m_matches; }
+
+		const Component::signature_t& get_registered_all()const { return m_registered_components; }
+
+		//! \brief Returns the component type whose pool was walked the last time the matches were rebuilt, the registered
+		//!		type with the fewest live components. Component::max_component_number + 1 if never rebuilt
+		Component::type_t get_driver_type()const { return m_driver_type; }
+
+		//! \brief Returns the number of entities tested the last time the matches were rebuilt
+		std::uint64_t get_driver_size()const { return m_driver_size; }
+
+		//! \brief Returns the registered components as a signature, an entity matches if it has all of them
+		const Component::signature_t& get_signature()const { return m_registered_components; }
 
-		const std::bitset<Component::max_component_number>& get_registered_all()const { return m_registered_components; }
+		//! \brief Enables chunked mode: the matches are split in chunks of p_chunk_size entities processed at the same time
+		//!		by the workers of the looper ( see SystemLooper::set_worker_count() ). process_range() / process_rows() must be thread-safe,
+		//!		preprocess() and finalize() still run once. 0 disables it ( default ), process() is called entity by entity
+		void set_chunk_size(std::size_t p_chunk_size) { m_chunk_size = p_chunk_size; }
+		std::size_t get_chunk_size()const { return m_chunk_size; }
+
+		//! \brief Number of workers that can call process_range() during this process(), valid from preprocess(). Size
+		//!		per-worker scratch data ( PerWorker ) with it and merge it in finalize()
+		std::size_t get_worker_count()const { return m_worker_count; }
+
+		//! \brief Returns the buffer of the worker running preprocess() / process() / finalize(). Structural changes 
+		//!		recorded there are applied at the end of the stage ( see SystemLooper::add_sync_point() ), entities and 
+		//!		components can then be added / removed while other systems are iterating. Only valid while the looper is 
+		//!		running the system. In chunked mode chunks run on several workers at once, process() must use 
+		//!		get_commands( p_entity ) and process_range() / process_rows() get_commands( p_worker )
+		CommandBuffer& get_commands() 
+		{ 
+			assert(m_worker != no_worker);
+			return get_commands(m_worker); 
+		}
+
+		//! \brief Returns the buffer of a worker, p_worker less than get_worker_count()
+		CommandBuffer& get_commands(std::size_t p_worker) { return *m_command_buffers[p_worker]; }
+
+		//! \brief Returns the buffer of the worker processing the entity, safe in process() in chunked mode too
+		CommandBuffer& get_commands(const EntityHandle& p_entity) { return get_commands(p_entity.get_worker()); }
 
 		virtual void preprocess() = 0;
 		virtual void process(EntityHandle& p_next_entity) = 0;
 		virtual void finalize() = 0;
 
+		//! \brief Processes a chunk of matches in chunked mode, by default calls process() on every entity with handles
+		//!		carrying the worker index ( EntityHandle::get_worker() )
+		//! \param [in] p_worker Index of the worker running the chunk, less than get_worker_count()
+		virtual void process_range(Entity* const* p_begin, Entity* const* p_end, std::size_t p_worker)
+		{
+			for (Entity* const* entity = p_begin; entity != p_end; ++entity)
+			{
+				EntityHandle handle(**entity, *m_entity_factory, *m_component_factory, p_worker);
+				process(handle);
+			}
+		}
+
+		//! \brief Processes the rows [ p_first_row, p_last_row ) of a matching table in archetype mode, by default calls 
+		//!		process_range() on every entity
+		virtual void process_rows(Archetype& p_archetype, std::size_t p_first_row, std::size_t p_last_row, std::size_t p_worker)
+		{
+			for (std::size_t row = p_first_row; row < p_last_row; ++row)
+			{
+				Entity* entity = p_archetype.get_entity(row);
+				process_range(&entity, &entity + 1, p_worker);
+			}
+		}
+
 		void enable() { m_enabled = true; }
 		void disable() { m_enabled = false; }
 		bool is_enabled()const { return m_enabled; }
 
+	protected:
+		//! \brief Called when the system is added to a looper, components can be registered from here
+		virtual void on_added() { }
+
+		//! \brief Returns the type ( index ) of the component in the factory of the looper
+		template <typename component_t>
+		Component::type_t get_component_type()const;
+
+		//! \brief True if the fields of the type are stored in their own columns ( see ComponentFactory::register_soa_component() )
+		template <typename component_t>
+		bool is_component_split()const { return m_component_factory->is_split(get_component_type<component_t>()); }
+
+		//! \brief Returns the values of a field of a type stored as structure of arrays for the rows [ p_first_row, p_last_row )
+		//!		of a table, the rows must be in the same chunk ( Archetype::get_chunk_end() )
+		template <typename component_t, typename field_t>
+		Span<field_t> get_field_span(const Archetype& p_archetype, field_t component_t::* p_field, std::size_t p_first_row, 
+			std::size_t p_last_row)const;
+
+		//! \brief Marks a component written without EntityHandle::modify_component() ( spans, process_rows() ) as changed
+		void mark_changed(Component& p_component)const { m_component_factory->mark_changed(p_component); }
+
 	protected:
 		bool			m_enabled;
-		std::bitset<Component::max_component_number> m_registered_components;
+		Component::signature_t m_registered_components;
 	
 	private :
+		// Adds / removes the entity from the cached matches
+		void _set_match(std::uint64_t p_entity_id, bool p_match)
+		{
+			const std::size_t id = static_cast<std::size_t>(p_entity_id);
+			if (id >= m_match_slots.size())
+			{
+				if (!p_match)
+					return;
+				const std::uint32_t empty = no_match;
+				m_match_slots.resize(id + 1, empty);
+			}
+
+			const std::uint32_t slot = m_match_slots[id];
+			if (p_match && slot == no_match)
+			{
+				m_match_slots[id] = static_cast<std::uint32_t>(m_matches.size());
+				m_matches.push_back(p_entity_id);
+			}
+			else if (!p_match && slot != no_match)
+			{
+				// Swapping with the last one, order does not matter
+				const std::uint64_t last = m_matches.back();
+				m_matches[slot] = last;
+				m_match_slots[static_cast<std::size_t>(last)] = slot;
+				m_matches.pop_back();
+				m_match_slots[id] = no_match;
+			}
+		}
+
+		void _clear_matches()
+		{
+			m_matches.clear();
+			m_match_slots.clear();
+		}
+
+	private :
+		static const std::uint32_t no_match{ ~static_cast<std::uint32_t>(0) };
+
+		EntityFactory* m_entity_factory;
 		ComponentFactory* m_component_factory;
+
+		// Profiling informations of the last rebuild
+		Component::type_t			m_driver_type;
+		std::uint64_t				m_driver_size;
+
+		// Entities matching the registered components, kept up to date by the SystemLooper. m_match_slots maps
+		// an entity id to its position in m_matches
+		std::vector<std::uint64_t>	m_matches;
+		std::vector<std::uint32_t>	m_match_slots;
+		bool						m_matches_dirty;	// Registered components changed, matches must be rebuilt
+
+		// Declared accesses, used to find the systems that can run in parallel
+		Component::signature_t		m_reads;
+		Component::signature_t		m_writes;
+		bool						m_access_declared;
+
+		// Chunked mode, m_range_entities holds the matches of the current process()
+		std::size_t					m_chunk_size;
+		std::size_t					m_worker_count;
+		std::vector<Entity*>		m_range_entities;
+
+		// Command buffers of the looper workers, set before every run. m_worker is no_worker while the chunks run
+		static const std::size_t	no_worker{ ~static_cast<std::size_t>(0) };
+		const std::unique_ptr<CommandBuffer>* m_command_buffers;
+		std::size_t					m_worker;
+
+		// Change tracking, see watch_component()
+		Component::signature_t		m_watched;
+		std::uint32_t				m_run_tick;			// Tick the current / last run started at
+		std::uint32_t				m_last_run_tick;	// Tick the run before started at
+		bool						m_has_run;
 	};
 
 	template <typename component_t>
-	void System::register_component()
+	void System::register_component(std::size_t p_alignment)
 	{
-		m_registered_components.set(static_cast<std::size_t>(m_component_factory->get_type_from_component<component_t>()), true);
+		const Component::type_t type = m_component_factory->register_component<component_t>(p_alignment);
+		m_registered_components.set(static_cast<std::size_t>(type));
+		m_matches_dirty = true;
 	}
 
 	template <typename component_t>
 	void System::unregister_component()
 	{
-		m_registered_components.set(m_component_factory->get_type_from_component<component_t>(), false);
+		const Component::type_t type = m_component_factory->get_type_from_component<component_t>();
+		if (type < Component::max_component_number)
+			m_registered_components.reset(static_cast<std::size_t>(type));
+		m_matches_dirty = true;
+	}
+
+	template <typename component_t>
+	void System::watch_component()
+	{
+		const Component::type_t type = m_component_factory->register_component<component_t>();
+		m_registered_components.set(static_cast<std::size_t>(type));
+		m_watched.set(static_cast<std::size_t>(type));
+		m_matches_dirty = true;
+	}
+
+	template <typename component_t>
+	void System::unwatch_component()
+	{
+		const Component::type_t type = get_component_type<component_t>();
+		if (type < Component::max_component_number)
+			m_watched.reset(static_cast<std::size_t>(type));
+	}
+
+	template <typename component_t>
+	void System::read_component()
+	{
+		m_reads.set(static_cast<std::size_t>(m_component_factory->register_component<component_t>()));
+		m_access_declared = true;
+	}
+
+	template <typename component_t>
+	void System::write_component()
+	{
+		m_writes.set(static_cast<std::size_t>(m_component_factory->register_component<component_t>()));
+		m_access_declared = true;
+	}
+
+	template <typename component_t>
+	Component::type_t System::get_component_type()const
+	{
+		return m_component_factory->get_type_from_component<component_t>();
+	}
+
+	template <typename component_t, typename field_t>
+	Span<field_t> System::get_field_span(const Archetype& p_archetype, field_t component_t::* p_field, std::size_t p_first_row, 
+		std::size_t p_last_row)const
+	{
+		const Component::type_t type = get_component_type<component_t>();
+		return p_archetype.get_field_span<field_t>(p_first_row, p_last_row, type, m_component_factory->get_field_index(type, get_field_offset(p_field)));
 	}
 
 	template <typename component_t>
 	bool System::is_component_registered()
 	{
-		return m_registered_components[m_component_factory->get_type_from_component<component_t>()];
+		const Component::type_t type = m_component_factory->get_type_from_component<component_t>();
+		return type < Component::max_component_number && m_registered_components.test(static_cast<std::size_t>(type));
 	}
 }
\ No newline at end of file
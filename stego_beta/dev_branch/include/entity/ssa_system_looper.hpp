@@ -6,11 +6,18 @@
 
 // Header
 #include "ssa_system.hpp"
+#include "ssa_entity_observer.hpp"
+#include "ssa_command_buffer.hpp"
+#include "../core/ssa_job_pool.hpp"
+#include "../core/ssa_type_index.hpp"
 
 // C++ STD
 #include <vector>
 #include <functional>
-#include <unordered_map>
+#include <mutex>
+#include <atomic>
+#include <memory>
+#include <cstdint>
 
 namespace ssa
 {
@@ -18,7 +25,24 @@ namespace ssa
 	class EntityFactory;
 	class ComponentFactory;
 
-	class ssa_export SystemLooper
+	//! \brief Runs the systems on the entities matching their registered components.
+	//!
+	//! In pools mode every system keeps a cached list of matching entities. The looper observes the factories and
+	//!	queues the entities whose composition changed, at the beginning of process() only those are tested again.
+	//!	Changes made while systems are running are applied the next process(), entities changed in the meantime are 
+	//!	checked before being handed to the system. In archetype mode the tables already group the matches.
+	//!
+	//! With more than one worker ( set_worker_count() ) systems that declared non-conflicting accesses run at the same
+	//!	time. Two systems conflict if one writes a type the other reads or writes, or if either did not declare its
+	//!	accesses, conflicting systems run in the order they were added. Sync points split the systems in stages, every
+	//!	system of a stage runs after all the ones of the previous stages.
+	//!
+	//! Every worker has a CommandBuffer ( System::get_commands() ), the commands recorded by the systems of a stage are
+	//!	played back once the whole stage finished, worker by worker. The systems of the next stages see the changes.
+	//!
+	//! The change tick of the ComponentFactory advances before every system runs, systems watching component types 
+	//!	( System::watch_component() ) only receive the entities whose watched components changed since their previous run
+	class ssa_export SystemLooper : public EntityObserver
 	{
 	public:
 		SystemLooper(EntityFactory& p_entity_factory,
@@ -27,6 +51,33 @@ namespace ssa
 
 		void process();
 
+		//! \brief Sets the number of threads running the systems, calling thread included. 1 runs them one after 
+		//!		the other on the calling thread ( default ), 0 uses one thread per hardware thread
+		void set_worker_count(std::size_t p_worker_count);
+
+		//! \brief Returns the number of threads running the systems
+		std::size_t get_worker_count()const { return m_job_pool != nullptr ? m_job_pool->get_worker_count() : 1; }
+
+		//! \brief Returns the pool running the systems, null if they run on the calling thread
+		JobPool* get_job_pool() { return m_job_pool.get(); }
+
+		//! \brief Systems added from now on run after all the ones already added have finished and their commands
+		//!		have been played back
+		void add_sync_point() { ++m_stage; }
+
+		//! \brief Returns the command buffer of a worker, p_worker less than get_worker_count(). Commands recorded 
+		//!		outside process() are played back at the end of the first stage
+		CommandBuffer& get_commands(std::size_t p_worker = 0) { return *m_command_buffers[p_worker]; }
+
+		//! \brief Drops all the cached matches, they are rebuilt by the next process(). Needed when entity ids change
+		//!		( compaction, snapshot loading )
+		void invalidate_matches();
+
+		// EntityObserver
+		void on_component_attached(Entity& p_entity, Component::type_t p_type) override;
+		void on_component_detached(Entity& p_entity, Component::type_t p_type) override;
+		void on_entity_removed(Entity& p_entity) override;
+
 		template <typename system_t, typename ...ctor_args>
 		void add_system(ctor_args ...p_ctor_args);
 
@@ -40,33 +91,131 @@ namespace ssa
 		void is_running();
 
 	private:
-		std::unordered_map<std::size_t, std::size_t> m_type_map;
+		// Node of the dependency graph, one per system
+		struct SystemNode
+		{
+			std::vector<std::size_t>	successors;		// Systems that can start only after this one finished
+			std::uint32_t				predecessors;	// Number of systems this one waits for
+		};
+
+		// Runs one system on its matches
+		// p_worker Worker running the system, 0 if not running on the pool
+		void _run_system(System& p_system, std::size_t p_worker);
+
+		// Gathers the matches of a system in chunked mode and runs process_range() on the pool
+		// p_watched Watched types of the system if only changed entities are processed, 0 otherwise
+		void _run_chunks(System& p_system, std::size_t p_worker, const Component::signature_t& p_watched);
+
+		// True if a component of the types in p_watched changed since the tick
+		static bool _is_changed(Entity& p_entity, const Component::signature_t& p_watched, std::uint32_t p_tick);
+
+		// True if a component of the types in p_watched changed since the tick in the rows [ p_first, p_last )
+		static bool _is_changed(const Archetype& p_archetype, std::size_t p_first, std::size_t p_last, 
+			const Component::signature_t& p_watched, std::uint32_t p_tick);
+
+		// Builds the dependency graph and runs the systems [ p_first, p_last ) on the job pool
+		void _process_parallel(std::size_t p_first, std::size_t p_last);
+
+		// Applies the commands recorded by all the workers
+		void _playback_commands();
+
+		// Runs a system then queues the successors that are not waiting for anything else
+		void _run_node(std::size_t p_node, std::size_t p_worker);
+
+		// True if the system added later ( p_second ) must wait for p_first
+		bool _conflicts(std::size_t p_first, std::size_t p_second)const;
+
+		// True if the entity has been changed since the beginning of the process()
+		bool _is_pending(Entity::id_t p_id);
+
+		// Queues the entity to be tested again, duplicates are ignored
+		void _mark_pending(const Entity& p_entity);
+
+		// Applies the pending changes to the cached matches of all the systems
+		void _update_matches();
+
+		// Fills the cache of a system from scratch
+		void _rebuild_matches(System& p_system);
+
+		// Returns the type in p_required with the fewest live components, p_required must not be empty
+		Component::type_t _select_driver(const Component::signature_t& p_required)const;
+
+		bool _matches(const Entity& p_entity, const System& p_system)const;
+
+	private:
+		static const std::size_t no_system{ ~static_cast<std::size_t>(0) };
+
+		std::vector<std::size_t>					 m_type_map;	// Indexed by TypeIndex<System>, position in m_systems or no_system
 		std::vector<System*>						 m_systems;
+		std::vector<std::size_t>					 m_stages;		// Stage of every system, see add_sync_point()
+		std::size_t									 m_stage;
 		EntityFactory*								 m_entity_factory;
 		ComponentFactory*							 m_component_factory;
+
+		// Entities whose composition changed since the last update, m_pending_flags is indexed by id
+		std::vector<std::uint64_t>					 m_pending;
+		std::vector<std::uint8_t>					 m_pending_flags;
+
+		// Scratch buffers of _rebuild_matches(), signatures are gathered contiguously to be filtered in batch
+		std::vector<std::uint64_t>					 m_scratch_ids;
+		std::vector<Component::signature_t>			 m_scratch_signatures;
+		std::vector<std::uint64_t>					 m_scratch_matches;
+		std::mutex									 m_pending_mutex;
+		std::atomic<std::size_t>					 m_pending_count;	// Size of m_pending, checked without the lock
+
+		// Parallel execution, see set_worker_count()
+		std::unique_ptr<JobPool>					 m_job_pool;
+		std::vector<SystemNode>						 m_graph;
+		std::unique_ptr<std::atomic<std::uint32_t>[]> m_remaining;	// Predecessors of every node still running
+		std::size_t									 m_first_node;	// System of the first node of the graph
+
+		// One per worker, see get_commands()
+		std::vector<std::unique_ptr<CommandBuffer>>	 m_command_buffers;
 	};
 
 	template <typename system_t, typename ...ctor_args>
 	void SystemLooper::add_system(ctor_args ...p_ctor_args)
 	{
 		m_systems.push_back(new system_t(p_ctor_args...));
+		m_systems.back()->m_entity_factory = m_entity_factory;
 		m_systems.back()->m_component_factory = m_component_factory;
-		std::size_t index = m_systems.size();
-
-		m_type_map.insert(std::make_pair(typeid(system_t).hash_code(), --index));
+		m_systems.back()->on_added();
+		m_stages.push_back(m_stage);
+
+		const std::size_t type = TypeIndex<System>::get<system_t>();
+		if (type >= m_type_map.size())
+		{
+			const std::size_t empty = no_system;
+			m_type_map.resize(type + 1, empty);
+		}
+		m_type_map[type] = m_systems.size() - 1;
 	}
 
 	template <typename system_t>
 	system_t& SystemLooper::get_system()
 	{
-		return *static_cast<system_t*>(m_systems[m_type_map[typeid(system_t).hash_code()]]);
+		return *static_cast<system_t*>(m_systems[m_type_map[TypeIndex<System>::get<system_t>()]]);
 	}
 
 	template <typename system_t>
 	void SystemLooper::remove_system()
 	{
-		delete m_systems[m_type_map[typeid(system_t).hash_code()]];
-		m_systems.erase(m_systems.begin() + m_type_map[typeid(system_t).hash_code()]);
+		const std::size_t type = TypeIndex<System>::get<system_t>();
+		if (type >= m_type_map.size() || m_type_map[type] == no_system)
+			return;
+
+		const std::size_t index = m_type_map[type];
+		delete m_systems[index];
+		m_systems.erase(m_systems.begin() + index);
+		m_stages.erase(m_stages.begin() + index);
+		m_type_map[type] = no_system;
+
+		// Systems after the removed one moved back by one
+		for (auto& entry : m_type_map)
+		{
+			if (entry != no_system && entry > index)
+				--entry;
+		}
 	}
 
 	template <typename system_t>
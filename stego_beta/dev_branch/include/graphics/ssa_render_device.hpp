@@ -4,7 +4,11 @@
 
 #pragma once
 
+// C++ STD
+#include <ostream>
+
 // ssa
+#include "../core/ssa_frame_arena.hpp"
 #include "ssa_commander.hpp"
 #include "ssa_resource_factory.hpp"
 
@@ -24,12 +28,22 @@ namespace ssa
 		typedef std::vector<std::reference_wrapper<Texture>> RenderTargetBlock;
 
 	public:
-		RenderDevice();
+		//! \param [in] p_allocator Source of the memory of the resource pools and of the frame arena, must outlive the device
+		RenderDevice(Allocator& p_allocator = get_default_allocator());
 		~RenderDevice();
 
 		//! \brief Initializes the RenderDevice attaching the underlying Commander to the specified adapter
 		bool init(unsigned int p_adapter_index);
 
+		//! \brief Returns the stats of every resource pool ( textures, buffers, shaders, samplers, blenders )
+		pool_stats_list_t get_pool_stats()const;
+
+		//! \brief Writes the stats of all the resource pools, one line per pool
+		void dump_stats(std::ostream& p_stream)const;
+
+		//! \brief Returns the arena for transient per-frame allocations, it is reset by finalize()
+		FrameArena& get_frame_arena() { return m_frame_arena; }
+
 		///////////////////////////////////////////////////////////////////////
 		/// CREATION
 		///////////////////////////////////////////////////////////////////////
@@ -153,7 +167,7 @@ namespace ssa
 		//! \return True if popping was successful, false if stack is emtpy ( or failed )
 		bool pop_targets();
 
-		RenderTargetBlock& get_rt_top() { return m_render_target_stack.back(); }
+		RenderTargetBlock& get_rt_top() { return m_render_target_stack[m_render_target_depth - 1]; }
 
 		//! \brief Binds the blender to the pipeline
 		//! \param [in] p_blender Blender to be bound
@@ -223,6 +237,15 @@ namespace ssa
 		ResourceFactory								 m_resource_factory;
 
 	private:
+		// Binds the render targets in the block on top of the stack
+		bool _bind_top_targets(bool p_bind_depth);
+
+	private:
+		// Blocks are never popped, only [ 0, m_render_target_depth ) are in use. Popped blocks keep their
+		// memory and are reused by the next push
 		std::vector<RenderTargetBlock> m_render_target_stack;
+		std::size_t					   m_render_target_depth;
+
+		FrameArena					   m_frame_arena;
 	};
 }
\ No newline at end of file
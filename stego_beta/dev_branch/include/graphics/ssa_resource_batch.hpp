@@ -11,6 +11,8 @@
 
 // ssa
 #include "../core/ssa_platform.hpp"
+#include "../core/ssa_pool_stats.hpp"
+#include "../core/ssa_allocator.hpp"
 
 namespace ssa
 {
@@ -20,7 +22,9 @@ namespace ssa
 	public:
 		typedef std::size_t index_t;
 	public:
-		ResourceBatch(std::size_t p_initial_size);
+		//! \param [in] p_initial_size Number of resources allocated upfront
+		//! \param [in] p_allocator Source of the resources and free list memory, must outlive the batch
+		ResourceBatch(std::size_t p_initial_size, Allocator& p_allocator = get_default_allocator());
 		~ResourceBatch();
 
 		index_t create_resource();
@@ -29,13 +33,20 @@ namespace ssa
 
 		void recycle(index_t p_index);
 
+		//! \brief Returns occupancy and memory usage of the batch
+		PoolStats get_stats()const;
+
 	private:
-		std::vector<resource_t>						m_resources;
-		std::list<index_t>							m_free_list;
+		std::vector<resource_t, StlAllocator<resource_t>>	m_resources;
+		std::list<index_t, StlAllocator<index_t>>			m_free_list;
+		std::size_t									m_high_water;
 	};
 
 	template <typename resource_t>
-	ResourceBatch<resource_t>::ResourceBatch(std::size_t p_initial_size)
+	ResourceBatch<resource_t>::ResourceBatch(std::size_t p_initial_size, Allocator& p_allocator) :
+		m_resources(StlAllocator<resource_t>(p_allocator)),
+		m_free_list(StlAllocator<index_t>(p_allocator)),
+		m_high_water{ 0 }
 	{
 		m_resources.resize(p_initial_size);
 
@@ -56,6 +67,8 @@ namespace ssa
 		index_t next_free = m_free_list.front();
 		m_free_list.pop_front();
 
+		m_high_water = std::max(m_high_water, m_resources.size() - m_free_list.size());
+
 		return next_free;
 	}
 
@@ -71,4 +84,21 @@ namespace ssa
 		// @TODO : implement deallocation callback
 		m_free_list.push_front(p_index);
 	}
+
+	template <typename resource_t>
+	PoolStats ResourceBatch<resource_t>::get_stats()const
+	{
+		// Every free spot is a list node ( value + two links )
+		const std::size_t node_size = sizeof(index_t) + 2 * sizeof(void*);
+
+		PoolStats stats;
+		stats.capacity = m_resources.size();
+		stats.live = m_resources.size() - m_free_list.size();
+		stats.high_water = m_high_water;
+		stats.bytes_reserved = m_resources.capacity() * sizeof(resource_t) + m_free_list.size() * node_size;
+		stats.bytes_used = stats.live * sizeof(resource_t);
+		stats.grow_events = 0; // Batches are allocated once
+		stats.free_list_length = m_free_list.size();
+		return stats;
+	}
 }
\ No newline at end of file
@@ -13,7 +13,8 @@ namespace ssa
 	class ssa_export ResourceFactory
 	{
 	public:
-		ResourceFactory(Commander& p_commander);
+		//! \param [in] p_allocator Source of the memory of all the resource batches, must outlive the factory
+		ResourceFactory(Commander& p_commander, Allocator& p_allocator = get_default_allocator());
 		~ResourceFactory();
 
 		ResourceBatch<TextureInternal>::index_t create_texture();
@@ -36,6 +37,9 @@ namespace ssa
 		BlenderInternal& get_blender(ResourceBatch<BlenderInternal>::index_t p_id);
 		void destroy_blender(ResourceBatch<BlenderInternal>::index_t p_id);
 
+		//! \brief Appends the stats of every resource batch to the list
+		void get_pool_stats(pool_stats_list_t& p_stats)const;
+
 	private:
 		Commander& m_commander;
 
@@ -0,0 +1,20 @@
+//! \copyright Mozilla Public License Version 2.0
+//! \note [License]		 license/license.txt
+//! \note [Contributors] license/contributors.txt
+
+// Header
+#include <core/ssa_allocator.hpp>
+
+namespace ssa
+{
+	namespace
+	{
+		// Stateless, safe to use during static initialization of other translation units
+		HeapAllocator g_default_allocator;
+	}
+
+	Allocator& get_default_allocator()
+	{
+		return g_default_allocator;
+	}
+}
\ No newline at end of file
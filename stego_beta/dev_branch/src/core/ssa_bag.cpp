@@ -7,25 +7,48 @@
 
 // C++ STD
 #include <algorithm>
+#include <chrono>
+#include <type_traits>
+
+// ssa
+#include <core/ssa_binary_stream.hpp>
 
 namespace ssa
 {
-	Bag::Bag(std::size_t p_element_size, std::size_t p_initial_buffer_size) :
-		m_data{ nullptr },
-		m_element_size{ p_element_size },
-		m_current_size{ 0 }
+	namespace
 	{
-		std::size_t to_allocate = m_element_size * p_initial_buffer_size;
+		// Written at the beginning of every Bag snapshot ( "SSAB" )
+		const std::uint32_t snapshot_magic{ 0x42415353 };
+	}
 
-		m_data = new uint8_t[to_allocate];
+	Bag::Bag(std::size_t p_element_size, std::size_t p_initial_capacity, std::size_t p_page_size, std::size_t p_alignment, Allocator& p_allocator) :
+		m_free_head{ free_index_mask },
+		m_pages{ nullptr },
+		m_page_table_size{ 0 },
+		m_page_count{ 0 },
+		m_element_size{ align_up(std::max(p_element_size, sizeof(index_t)), _element_alignment(p_element_size, p_alignment)) }, // Free spots store the next free index
+		m_alignment{ _element_alignment(p_element_size, p_alignment) },
+		m_page_shift{ 0 },
+		m_page_mask{ 0 },
+		m_words_per_page{ 0 },
+		m_capacity{ 0 },
+		m_size{ 0 },
+		m_high_water{ 0 },
+		m_grow_count{ 0 },
+		m_concurrent{ false },
+		m_allocator{ &p_allocator }
+	{
+		std::memset(&m_last_grow, 0, sizeof(GrowEvent));
+		std::memset(&m_traits, 0, sizeof(ObjectTraits));
 
-		m_current_size = p_initial_buffer_size;
+		// Rounding page size to the next power of two, indexing is then a shift and a mask
+		while ((static_cast<std::size_t>(1) << m_page_shift) < std::max<std::size_t>(p_page_size, 1))
+			++m_page_shift;
+		m_page_mask = (static_cast<std::size_t>(1) << m_page_shift) - 1;
+		m_words_per_page = (m_page_mask + 64) / 64;
 
-		// Generating free spots
-		m_free_list.resize(static_cast<std::size_t>(m_current_size));
-		index_t index{ 0 };
-		std::generate(m_free_list.begin(), m_free_list.end(), [&] { return index++; });
-		std::memset(m_data, 0, m_element_size * static_cast<std::size_t>(m_current_size));
+		if (p_initial_capacity > 0)
+			_grow(p_initial_capacity, false);
 	}
 
 	Bag::~Bag()
@@ -35,23 +58,488 @@ namespace ssa
 
 	void Bag::recycle(index_t p_index)
 	{
+		assert(is_occupied(p_index));
+
 		// Erasing object
-		std::memset(m_data + p_index * m_element_size, 0, m_element_size);
+		uint8_t* object = get_element_ptr(p_index);
+		if (m_traits.destroy != nullptr)
+			m_traits.destroy(object);
+		std::memset(object, 0, m_element_size);
+
+		_set_occupied(p_index, false);
+		_add_size(-1);
 
 		// Adding to free list
-		m_free_list.push_front(p_index);
+		_push_free(p_index, p_index);
+	}
+
+	void Bag::reserve(std::size_t p_count)
+	{
+		const std::size_t free_spots = static_cast<std::size_t>(get_capacity() - get_size());
+		if (p_count > free_spots)
+			_grow(p_count - free_spots, false);
+	}
+
+	Bag::index_t Bag::next_object(index_t p_index)const
+	{
+		if (p_index >= get_capacity())
+			return npos;
+
+		const Page* pages = m_pages.load(std::memory_order_acquire);
+		const std::size_t page_count = get_page_count();
+		std::size_t page = static_cast<std::size_t>(p_index >> m_page_shift);
+		std::size_t word = static_cast<std::size_t>(p_index & m_page_mask) >> 6;
+
+		// Masking out the slots before p_index in the first word
+		std::uint64_t bits = pages[page].occupancy[word].load(std::memory_order_relaxed) & (~static_cast<std::uint64_t>(0) << (p_index & m_page_mask & 63));
+		while (bits == 0)
+		{
+			if (++word == m_words_per_page)
+			{
+				word = 0;
+				if (++page == page_count)
+					return npos;
+			}
+			bits = pages[page].occupancy[word].load(std::memory_order_relaxed);
+		}
+
+		return (static_cast<index_t>(page) << m_page_shift) + static_cast<index_t>(word) * 64 + count_trailing_zeros(bits);
+	}
+
+	PoolStats Bag::get_stats()const
+	{
+		PoolStats stats;
+		stats.capacity = get_capacity();
+		stats.live = get_size();
+		stats.high_water = m_high_water.load(std::memory_order_relaxed);
+		stats.bytes_reserved = get_page_count() * _page_block_size() + m_page_table_size * sizeof(Page);
+		stats.bytes_used = stats.live * m_element_size;
+		stats.grow_events = m_grow_count;
+		stats.free_list_length = stats.capacity - stats.live; // Every spot not alive is linked in the free list
+		return stats;
+	}
+
+	Bag::remap_t Bag::compact()
+	{
+		remap_t remap;
+
+		// Filling the lowest holes with the highest live elements
+		const index_t capacity = get_capacity();
+		index_t hole = 0;
+		index_t last = capacity;
+		while (true)
+		{
+			while (hole < capacity && is_occupied(hole))
+				++hole;
+			while (last > 0 && !is_occupied(last - 1))
+				--last;
+			if (last == 0 || hole >= last - 1)
+				break;
+
+			const index_t from = last - 1;
+			_relocate(get_element_ptr(hole), get_element_ptr(from));
+			_set_occupied(hole, true);
+			_set_occupied(from, false);
+
+			Relocation relocation;
+			relocation.from = from;
+			relocation.to = hole;
+			remap.push_back(relocation);
+		}
+
+		// Live elements are now [0, size), releasing the pages past them
+		const index_t size = get_size();
+		const std::size_t page_size = m_page_mask + 1;
+		const std::size_t used_pages = static_cast<std::size_t>((size + page_size - 1) / page_size);
+		Page* pages = m_pages.load(std::memory_order_relaxed);
+		for (std::size_t page = used_pages; page < get_page_count(); ++page)
+			m_allocator->deallocate(pages[page].data, _page_block_size());
+		m_page_count.store(used_pages, std::memory_order_release);
+		m_capacity.store(static_cast<index_t>(used_pages * page_size), std::memory_order_release);
+
+		// Rebuilding the free list with the spots left in the last page
+		m_free_head.store(free_index_mask, std::memory_order_relaxed);
+		if (size < get_capacity())
+		{
+			for (index_t spot = size; spot < get_capacity() - 1; ++spot)
+				_set_link(spot, spot + 1);
+			_push_free(size, get_capacity() - 1);
+		}
+
+		return remap;
+	}
+
+	bool Bag::write_snapshot(std::ostream& p_stream)const
+	{
+		if (!is_trivially_copyable())
+			return false;
+
+		const Page* pages = m_pages.load(std::memory_order_acquire);
+		const std::size_t page_count = get_page_count();
+
+		bool ok = write_binary(p_stream, snapshot_magic) &&
+			write_binary(p_stream, static_cast<std::uint64_t>(m_element_size)) &&
+			write_binary(p_stream, static_cast<std::uint64_t>(m_alignment)) &&
+			write_binary(p_stream, static_cast<std::uint64_t>(get_page_size())) &&
+			write_binary(p_stream, static_cast<std::uint64_t>(page_count)) &&
+			write_binary(p_stream, static_cast<std::uint64_t>(get_size())) &&
+			write_binary(p_stream, static_cast<std::uint64_t>(m_high_water.load(std::memory_order_relaxed))) &&
+			write_binary(p_stream, static_cast<std::uint64_t>(m_free_head.load(std::memory_order_acquire) & free_index_mask));
+
+		// Page addresses first, then every page block ( elements and occupancy words ) as it is in memory
+		for (std::size_t page = 0; ok && page < page_count; ++page)
+			ok = write_binary(p_stream, static_cast<std::uint64_t>(reinterpret_cast<std::uintptr_t>(pages[page].data)));
+
+		for (std::size_t page = 0; ok && page < page_count; ++page)
+		{
+			p_stream.write(reinterpret_cast<const char*>(pages[page].data), static_cast<std::streamsize>(_page_block_size()));
+			ok = p_stream.good();
+		}
+
+		return ok;
+	}
+
+	bool Bag::read_snapshot(std::istream& p_stream, SnapshotLayout* p_layout)
+	{
+		std::uint32_t magic;
+		std::uint64_t element_size, alignment, page_size, page_count, size, high_water, free_index;
+		if (!(read_binary(p_stream, magic) && read_binary(p_stream, element_size) && read_binary(p_stream, alignment) &&
+			read_binary(p_stream, page_size) && read_binary(p_stream, page_count) && read_binary(p_stream, size) && 
+			read_binary(p_stream, high_water) && read_binary(p_stream, free_index)))
+			return false;
+
+		if (magic != snapshot_magic || element_size != m_element_size || alignment != m_alignment || 
+			page_size != get_page_size() || !is_trivially_copyable())
+			return false;
+
+		// The free list can't address more than free_index_mask spots, the counters must fit in the pages
+		const std::uint64_t max_pages = free_index_mask / page_size;
+		const std::uint64_t capacity = page_count * page_size;
+		if (page_count > max_pages || size > capacity || high_water > capacity || (free_index != free_index_mask && free_index >= capacity))
+			return false;
+
+		// Growing as the addresses are read, a corrupt page count can't allocate more than the stream holds
+		std::vector<std::uint64_t> addresses;
+		for (std::uint64_t page = 0; page < page_count; ++page)
+		{
+			std::uint64_t address;
+			if (!read_binary(p_stream, address))
+				return false;
+			addresses.push_back(address);
+		}
+
+		// Dropping the current content, elements are trivially copyable there's nothing to destroy
+		_safe_release();
+		m_page_table_size = 0;
+		m_size.store(0, std::memory_order_relaxed);
+		m_free_head.store(free_index_mask, std::memory_order_relaxed);
+
+		if (page_count > 0)
+		{
+			Page* pages = _allocate_table(static_cast<std::size_t>(page_count));
+			m_page_table_size = static_cast<std::size_t>(page_count);
+			m_pages.store(pages, std::memory_order_release);
+
+			const std::size_t block_size = _page_block_size();
+			for (std::size_t page = 0; page < page_count; ++page)
+			{
+				pages[page].data = static_cast<uint8_t*>(m_allocator->allocate(block_size, _page_alignment()));
+				assert(pages[page].data != nullptr);
+				pages[page].occupancy = reinterpret_cast<std::atomic<std::uint64_t>*>(pages[page].data + _page_data_size());
+				m_page_count.store(page + 1, std::memory_order_relaxed);
+
+				p_stream.read(reinterpret_cast<char*>(pages[page].data), static_cast<std::streamsize>(block_size));
+				if (!p_stream.good())
+				{
+					_safe_release();
+					m_page_table_size = 0;
+					return false;
+				}
+			}
+		}
+
+		m_capacity.store(capacity, std::memory_order_release);
+		if (!_is_consistent(size, free_index))
+		{
+			_safe_release();
+			m_page_table_size = 0;
+			return false;
+		}
+
+		m_size.store(size, std::memory_order_relaxed);
+		m_high_water.store(high_water, std::memory_order_relaxed);
+		m_free_head.store(free_index, std::memory_order_release); // Tag restarts from 0
+
+		if (p_layout != nullptr)
+		{
+			p_layout->page_size = get_page_size();
+			p_layout->element_size = m_element_size;
+			p_layout->pages.clear();
+			for (std::size_t page = 0; page < addresses.size(); ++page)
+				p_layout->pages.push_back(std::make_pair(addresses[page], static_cast<index_t>(page) << m_page_shift));
+			std::sort(p_layout->pages.begin(), p_layout->pages.end());
+		}
+
+		return true;
+	}
+
+	Bag::index_t Bag::SnapshotLayout::find(const void* p_address)const
+	{
+		const std::uint64_t address = static_cast<std::uint64_t>(reinterpret_cast<std::uintptr_t>(p_address));
+
+		// Last page starting at or before the address
+		const index_t last_index = npos;
+		auto page = std::upper_bound(pages.begin(), pages.end(), std::make_pair(address, last_index));
+		if (page == pages.begin())
+			return npos;
+		--page;
+
+		const std::uint64_t offset = address - page->first;
+		if (offset >= static_cast<std::uint64_t>(page_size) * element_size)
+			return npos;
+
+		return page->second + offset / element_size;
+	}
+
+	bool Bag::_is_consistent(index_t p_size, index_t p_free_index)const
+	{
+		// Occupancy bits past the end of a page would be walked as elements
+		const std::size_t page_size = get_page_size();
+		const Page* pages = m_pages.load(std::memory_order_relaxed);
+		index_t occupied = 0;
+		for (std::size_t page = 0; page < get_page_count(); ++page)
+		{
+			for (std::size_t w = 0; w < m_words_per_page; ++w)
+			{
+				const std::uint64_t bits = pages[page].occupancy[w].load(std::memory_order_relaxed);
+				const std::size_t valid = std::min<std::size_t>(64, page_size - w * 64);
+				if (valid < 64 && (bits >> valid) != 0)
+					return false;
+				occupied += pop_count(bits);
+			}
+		}
+		if (occupied != p_size)
+			return false;
+
+		// Every free spot is linked exactly once, a cycle or a link out of the pages would break the next allocation
+		const index_t free_count = get_capacity() - p_size;
+		index_t spot = p_free_index;
+		for (index_t linked = 0; linked < free_count; ++linked)
+		{
+			if (spot >= get_capacity() || is_occupied(spot))
+				return false;
+			spot = _get_link(spot) & free_index_mask;
+		}
+		return spot == free_index_mask;
+	}
+
+	void Bag::_relocate(uint8_t* p_destination, uint8_t* p_source)
+	{
+		if (m_traits.relocate != nullptr)
+			m_traits.relocate(p_destination, p_source);
+		else
+			std::memcpy(p_destination, p_source, m_element_size);
+		std::memset(p_source, 0, m_element_size);
 	}
 
 	void Bag::_safe_release()
 	{
-		if (m_data != nullptr)
-			delete[] m_data;
+		if (m_traits.destroy != nullptr)
+		{
+			for_each([&](index_t p_index)
+			{
+				m_traits.destroy(get_element_ptr(p_index));
+			});
+		}
+
+		Page* pages = m_pages.load(std::memory_order_relaxed);
+		for (std::size_t page = 0; page < get_page_count(); ++page)
+			m_allocator->deallocate(pages[page].data, _page_block_size());
+		if (pages != nullptr)
+			m_allocator->deallocate(pages, m_page_table_size * sizeof(Page));
+		for (auto& table : m_retired_tables)
+			m_allocator->deallocate(table.first, table.second * sizeof(Page));
+
+		m_pages.store(nullptr, std::memory_order_relaxed);
+		m_retired_tables.clear();
+		m_page_count.store(0, std::memory_order_relaxed);
+		m_capacity.store(0, std::memory_order_relaxed);
+	}
+
+	Bag::Page* Bag::_allocate_table(std::size_t p_size)
+	{
+		Page* table = static_cast<Page*>(m_allocator->allocate(p_size * sizeof(Page), std::alignment_of<Page>::value));
+		assert(table != nullptr);
+		for (std::size_t i = 0; i < p_size; ++i)
+		{
+			table[i].data = nullptr;
+			table[i].occupancy = nullptr;
+		}
+		return table;
+	}
+
+	void Bag::_grow(std::size_t p_count, bool p_only_if_empty)
+	{
+		std::lock_guard<std::mutex> lock(m_grow_mutex);
+
+		// Another thread might have grown the bag while we were waiting
+		if (p_only_if_empty && (m_free_head.load(std::memory_order_acquire) & free_index_mask) != free_index_mask)
+			return;
+
+		auto start = std::chrono::high_resolution_clock::now();
+
+		const std::size_t page_size = m_page_mask + 1;
+		const std::size_t page_bytes = _page_block_size();
+		const std::size_t new_pages = (p_count + page_size - 1) / page_size;
+		const std::size_t page_count = get_page_count();
+
+		GrowEvent grow_event;
+		grow_event.pages = new_pages;
+		grow_event.bytes = new_pages * page_bytes;
+		grow_event.old_capacity = get_capacity();
+
+		// Replacing the page table if full, the old one stays valid for the threads still reading it
+		Page* pages = m_pages.load(std::memory_order_relaxed);
+		if (page_count + new_pages > m_page_table_size)
+		{
+			std::size_t new_table_size = std::max<std::size_t>(m_page_table_size * 2, page_count + new_pages);
+			Page* new_table = _allocate_table(new_table_size);
+			if (pages != nullptr)
+			{
+				std::copy(pages, pages + page_count, new_table);
+				m_retired_tables.push_back(std::make_pair(pages, m_page_table_size));
+			}
+			pages = new_table;
+			m_page_table_size = new_table_size;
+			m_pages.store(pages, std::memory_order_release);
+		}
+
+		for (std::size_t i = 0; i < new_pages; ++i)
+		{
+			Page& page = pages[page_count + i];
+			page.data = static_cast<uint8_t*>(m_allocator->allocate(page_bytes, _page_alignment()));
+			assert(page.data != nullptr);
+			std::memset(page.data, 0, page_bytes);
+
+			page.occupancy = reinterpret_cast<std::atomic<std::uint64_t>*>(page.data + _page_data_size());
+			for (std::size_t w = 0; w < m_words_per_page; ++w)
+				new (page.occupancy + w) std::atomic<std::uint64_t>(0);
+		}
+
+		// Publishing the pages before handing out their spots
+		const index_t old_capacity = get_capacity();
+		const index_t new_capacity = old_capacity + new_pages * page_size;
+		m_page_count.store(page_count + new_pages, std::memory_order_release);
+		m_capacity.store(new_capacity, std::memory_order_release);
+
+		// Linking new spots in ascending order and pushing them all at once
+		for (index_t spot = old_capacity; spot < new_capacity - 1; ++spot)
+			_set_link(spot, spot + 1);
+		_push_free(old_capacity, new_capacity - 1);
+
+		grow_event.new_capacity = new_capacity;
+		grow_event.microseconds = static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::microseconds>(
+			std::chrono::high_resolution_clock::now() - start).count());
+
+		m_last_grow = grow_event;
+		++m_grow_count;
+		if (m_grow_callback)
+			m_grow_callback(m_last_grow);
 	}
 
 	Bag::index_t Bag::_get_next_spot()
 	{
-		index_t next_spot{ m_free_list.front() };
-		m_free_list.pop_front();
+		std::uint64_t head = m_free_head.load(std::memory_order_acquire);
+		index_t next_spot;
+		while (true)
+		{
+			next_spot = head & free_index_mask;
+			if (next_spot == free_index_mask)
+			{
+				_grow(m_page_mask + 1, true);
+				head = m_free_head.load(std::memory_order_acquire);
+				continue;
+			}
+
+			// In concurrent mode the link might be stale if another thread popped the spot meanwhile, the tag makes the CAS fail
+			const std::uint64_t new_head = (_get_link(next_spot) & free_index_mask) | (((head >> free_index_bits) + 1) << free_index_bits);
+			if (!m_concurrent)
+			{
+				m_free_head.store(new_head, std::memory_order_relaxed);
+				break;
+			}
+
+			if (m_free_head.compare_exchange_weak(head, new_head, std::memory_order_acq_rel, std::memory_order_acquire))
+				break;
+		}
+
+		std::memset(get_element_ptr(next_spot), 0, sizeof(index_t));
+
+		_set_occupied(next_spot, true);
+		_add_size(1);
+
 		return next_spot;
 	}
+
+	void Bag::_push_free(index_t p_first, index_t p_last)
+	{
+		std::uint64_t head = m_free_head.load(std::memory_order_relaxed);
+		while (true)
+		{
+			_set_link(p_last, head & free_index_mask);
+			const std::uint64_t new_head = p_first | (((head >> free_index_bits) + 1) << free_index_bits);
+			if (!m_concurrent)
+			{
+				m_free_head.store(new_head, std::memory_order_release);
+				return;
+			}
+
+			if (m_free_head.compare_exchange_weak(head, new_head, std::memory_order_acq_rel, std::memory_order_relaxed))
+				return;
+		}
+	}
+
+	void Bag::_set_link(index_t p_index, index_t p_next)
+	{
+		std::memcpy(get_element_ptr(p_index), &p_next, sizeof(index_t));
+	}
+
+	Bag::index_t Bag::_get_link(index_t p_index)const
+	{
+		index_t next;
+		std::memcpy(&next, get_element_ptr(p_index), sizeof(index_t));
+		return next;
+	}
+
+	void Bag::_set_occupied(index_t p_index, bool p_occupied)
+	{
+		std::atomic<std::uint64_t>& word = _occupancy_word(p_index);
+		const std::uint64_t bit = _occupancy_bit(p_index);
+		if (m_concurrent)
+		{
+			if (p_occupied)
+				word.fetch_or(bit, std::memory_order_relaxed);
+			else
+				word.fetch_and(~bit, std::memory_order_relaxed);
+		}
+		else
+			word.store(p_occupied ? word.load(std::memory_order_relaxed) | bit : word.load(std::memory_order_relaxed) & ~bit, std::memory_order_relaxed);
+	}
+
+	void Bag::_add_size(std::int64_t p_delta)
+	{
+		index_t size;
+		if (m_concurrent)
+			size = m_size.fetch_add(static_cast<index_t>(p_delta), std::memory_order_relaxed) + static_cast<index_t>(p_delta);
+		else
+		{
+			size = m_size.load(std::memory_order_relaxed) + static_cast<index_t>(p_delta);
+			m_size.store(size, std::memory_order_relaxed);
+		}
+
+		// Updating high water mark
+		index_t high_water = m_high_water.load(std::memory_order_relaxed);
+		while (size > high_water && !m_high_water.compare_exchange_weak(high_water, size, std::memory_order_relaxed))
+			;
+	}
 }
\ No newline at end of file
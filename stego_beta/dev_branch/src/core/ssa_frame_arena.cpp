@@ -0,0 +1,92 @@
+//! \copyright Mozilla Public License Version 2.0
+//! \note [License]		 license/license.txt
+//! \note [Contributors] license/contributors.txt
+
+// Header
+#include <core/ssa_frame_arena.hpp>
+
+// C++ STD
+#include <algorithm>
+#include <cassert>
+
+namespace ssa
+{
+	FrameArena::FrameArena(std::size_t p_capacity, bool p_double_buffered, Allocator& p_allocator) :
+		m_current{ 0 },
+		m_double_buffered{ p_double_buffered },
+		m_used{ 0 },
+		m_peak{ 0 },
+		m_overflow_count{ 0 },
+		m_allocator{ &p_allocator }
+	{
+		for (unsigned int i = 0; i < 2; ++i)
+		{
+			const bool used = i == 0 || m_double_buffered;
+			m_buffers[i].data = used ? static_cast<std::uint8_t*>(m_allocator->allocate(p_capacity, default_alignment)) : nullptr;
+			m_buffers[i].offset = 0;
+			m_buffers[i].capacity = used ? p_capacity : 0;
+		}
+	}
+
+	FrameArena::~FrameArena()
+	{
+		for (unsigned int i = 0; i < 2; ++i)
+		{
+			if (m_buffers[i].data != nullptr)
+				m_allocator->deallocate(m_buffers[i].data, m_buffers[i].capacity);
+			for (auto& block : m_overflow_blocks[i])
+				m_allocator->deallocate(block.first, block.second);
+		}
+	}
+
+	void* FrameArena::allocate(std::size_t p_size, std::size_t p_alignment)
+	{
+		Buffer& buffer = m_buffers[m_current];
+
+		// Aligning the address, not the offset, buffers are only aligned to default_alignment
+		const std::uintptr_t base = reinterpret_cast<std::uintptr_t>(buffer.data);
+		const std::size_t offset = static_cast<std::size_t>(align_up(static_cast<std::size_t>(base + buffer.offset), p_alignment) - base);
+		if (buffer.data != nullptr && offset + p_size <= buffer.capacity)
+		{
+			m_used += offset + p_size - buffer.offset;
+			buffer.offset = offset + p_size;
+			return buffer.data + offset;
+		}
+
+		// Not enough space, the buffer will be resized at the next reset()
+		++m_overflow_count;
+		m_used += p_size + p_alignment;
+		const std::size_t size = std::max<std::size_t>(p_size, 1);
+		void* block = m_allocator->allocate(size, std::max(p_alignment, default_alignment));
+		assert(block != nullptr);
+		m_overflow_blocks[m_current].push_back(std::make_pair(block, size));
+		return block;
+	}
+
+	void FrameArena::reset()
+	{
+		m_peak = std::max(m_peak, m_used);
+		m_used = 0;
+
+		if (m_double_buffered)
+			m_current = 1 - m_current;
+
+		// The buffer we are switching to is not used anymore, releasing its overflow
+		for (auto& block : m_overflow_blocks[m_current])
+			m_allocator->deallocate(block.first, block.second);
+		m_overflow_blocks[m_current].clear();
+
+		// Fitting the peak ( plus some alignment slack ) so that the next frames do not overflow. When double buffered
+		// the other buffer is still in use, it is resized when we switch back to it
+		Buffer& buffer = m_buffers[m_current];
+		if (m_peak > buffer.capacity)
+		{
+			if (buffer.data != nullptr)
+				m_allocator->deallocate(buffer.data, buffer.capacity);
+			buffer.capacity = m_peak + m_peak / 8;
+			buffer.data = static_cast<std::uint8_t*>(m_allocator->allocate(buffer.capacity, default_alignment));
+		}
+
+		buffer.offset = 0;
+	}
+}
\ No newline at end of file
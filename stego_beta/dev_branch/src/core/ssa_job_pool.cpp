@@ -0,0 +1,148 @@
+//! \copyright Mozilla Public License Version 2.0
+//! \note [License]		 license/license.txt
+//! \note [Contributors] license/contributors.txt
+
+// Header
+#include <core/ssa_job_pool.hpp>
+
+// C++ STD
+#include <algorithm>
+#include <cassert>
+
+namespace ssa
+{
+	JobPool::JobPool(std::size_t p_worker_count) :
+		m_worker_count{ p_worker_count },
+		m_queued{ 0 },
+		m_outstanding{ 0 },
+		m_stop{ false }
+	{
+		if (m_worker_count == 0)
+			m_worker_count = std::max<std::size_t>(std::thread::hardware_concurrency(), 1);
+
+		m_queues.reset(new Queue[m_worker_count]);
+		for (std::size_t worker = 1; worker < m_worker_count; ++worker)
+			m_threads.push_back(std::thread(&JobPool::_worker_loop, this, worker));
+	}
+
+	JobPool::~JobPool()
+	{
+		{
+			std::lock_guard<std::mutex> lock(m_sleep_mutex);
+			m_stop.store(true);
+		}
+		m_sleep_cv.notify_all();
+
+		for (auto& thread : m_threads)
+			thread.join();
+	}
+
+	void JobPool::push(const job_t& p_job, std::size_t p_worker, counter_t* p_counter)
+	{
+		assert(p_worker < m_worker_count);
+
+		if (p_counter != nullptr)
+			p_counter->fetch_add(1);
+		m_outstanding.fetch_add(1);
+		{
+			Queue& queue = m_queues[p_worker];
+			std::lock_guard<std::mutex> lock(queue.mutex);
+			QueuedJob queued;
+			queued.job = p_job;
+			queued.counter = p_counter;
+			queue.jobs.push_back(std::move(queued));
+		}
+		m_queued.fetch_add(1);
+
+		// Taking the lock so that a thread checking the condition cannot miss the notification
+		{
+			std::lock_guard<std::mutex> lock(m_sleep_mutex);
+		}
+		m_sleep_cv.notify_one();
+	}
+
+	void JobPool::wait_idle()
+	{
+		while (m_outstanding.load() != 0)
+		{
+			if (_run_one(0))
+				continue;
+
+			std::unique_lock<std::mutex> lock(m_sleep_mutex);
+			m_sleep_cv.wait(lock, [this] { return _can_wake(true); });
+		}
+	}
+
+	void JobPool::wait(const counter_t& p_counter, std::size_t p_worker)
+	{
+		// Jobs of the group can be running on other workers, helping with whatever is queued meanwhile
+		while (p_counter.load() != 0)
+		{
+			if (!_run_one(p_worker))
+				std::this_thread::yield();
+		}
+	}
+
+	void JobPool::_worker_loop(std::size_t p_worker)
+	{
+		while (!m_stop.load())
+		{
+			if (_run_one(p_worker))
+				continue;
+
+			std::unique_lock<std::mutex> lock(m_sleep_mutex);
+			m_sleep_cv.wait(lock, [this] { return _can_wake(false); });
+		}
+	}
+
+	bool JobPool::_run_one(std::size_t p_worker)
+	{
+		QueuedJob queued;
+		queued.counter = nullptr;
+
+		// Newest job of the own queue first, then the oldest of the others
+		for (std::size_t i = 0; i < m_worker_count && !queued.job; ++i)
+		{
+			Queue& queue = m_queues[(p_worker + i) % m_worker_count];
+			std::lock_guard<std::mutex> lock(queue.mutex);
+			if (queue.jobs.empty())
+				continue;
+
+			if (i == 0)
+			{
+				queued = std::move(queue.jobs.back());
+				queue.jobs.pop_back();
+			}
+			else
+			{
+				queued = std::move(queue.jobs.front());
+				queue.jobs.pop_front();
+			}
+		}
+
+		if (!queued.job)
+			return false;
+
+		m_queued.fetch_sub(1);
+		queued.job(p_worker);
+		if (queued.counter != nullptr)
+			queued.counter->fetch_sub(1);
+
+		if (m_outstanding.fetch_sub(1) == 1)
+		{
+			// Last job done, waking up wait_idle()
+			{
+				std::lock_guard<std::mutex> lock(m_sleep_mutex);
+			}
+			m_sleep_cv.notify_all();
+		}
+		return true;
+	}
+
+	bool JobPool::_can_wake(bool p_waiting_idle)const
+	{
+		if (m_stop.load() || m_queued.load() != 0)
+			return true;
+		return p_waiting_idle && m_outstanding.load() == 0;
+	}
+}
\ No newline at end of file
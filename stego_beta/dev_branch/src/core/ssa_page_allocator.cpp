@@ -0,0 +1,105 @@
+//! \copyright Mozilla Public License Version 2.0
+//! \note [License]		 license/license.txt
+//! \note [Contributors] license/contributors.txt
+
+// Header
+#include <core/ssa_page_allocator.hpp>
+
+// C++ STD
+#include <cassert>
+
+#if defined(ssa_os_linux)
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+namespace ssa
+{
+	PageAllocator::PageAllocator(bool p_huge_pages) :
+		m_page_size{ 4096 },
+		m_huge_page_size{ 0 },
+		m_huge_allocations{ 0 }
+	{
+#if defined(ssa_os_windows)
+		SYSTEM_INFO info;
+		GetSystemInfo(&info);
+		m_page_size = static_cast<std::size_t>(info.dwPageSize);
+		if (p_huge_pages)
+			m_huge_page_size = static_cast<std::size_t>(GetLargePageMinimum());
+#elif defined(ssa_os_linux)
+		m_page_size = static_cast<std::size_t>(sysconf(_SC_PAGESIZE));
+		if (p_huge_pages)
+			m_huge_page_size = 2 * 1024 * 1024; // Default huge page size on x86-64
+#endif
+	}
+
+	void* PageAllocator::allocate(std::size_t p_size, std::size_t p_alignment)
+	{
+		assert(is_power_of_two(p_alignment) && p_alignment <= m_page_size);
+
+		// Huge pages only make sense if we fill at least one of them
+		const bool huge = m_huge_page_size != 0 && p_size >= m_huge_page_size;
+
+#if defined(ssa_os_windows)
+		if (huge)
+		{
+			// Requires the SeLockMemoryPrivilege, fails otherwise
+			void* memory = VirtualAlloc(nullptr, _round_up(p_size, true), MEM_RESERVE | MEM_COMMIT | MEM_LARGE_PAGES, PAGE_READWRITE);
+			if (memory != nullptr)
+			{
+				m_huge_allocations.fetch_add(1, std::memory_order_relaxed);
+				return memory;
+			}
+		}
+
+		return VirtualAlloc(nullptr, _round_up(p_size, false), MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE);
+#elif defined(ssa_os_linux)
+		void* memory = MAP_FAILED;
+		if (huge)
+		{
+			// Fails if no huge pages have been reserved ( vm.nr_hugepages )
+			memory = mmap(nullptr, _round_up(p_size, true), PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+			if (memory != MAP_FAILED)
+			{
+				m_huge_allocations.fetch_add(1, std::memory_order_relaxed);
+				return memory;
+			}
+		}
+
+		// Keeping the huge page rounding for the fallback too, deallocate() can't tell the two apart and
+		// pages are only committed when touched
+		const std::size_t size = _round_up(p_size, huge);
+		memory = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+		if (memory == MAP_FAILED)
+			return nullptr;
+		
+		if (huge)
+			madvise(memory, size, MADV_HUGEPAGE);
+
+		return memory;
+#else
+		return aligned_malloc(p_size, p_alignment);
+#endif
+	}
+
+	void PageAllocator::deallocate(void* p_memory, std::size_t p_size)
+	{
+		if (p_memory == nullptr)
+			return;
+
+#if defined(ssa_os_windows)
+		VirtualFree(p_memory, 0, MEM_RELEASE);
+#elif defined(ssa_os_linux)
+		// Same rounding used by allocate(), huge mappings must be unmapped in multiples of the huge page size
+		const bool huge = m_huge_page_size != 0 && p_size >= m_huge_page_size;
+		munmap(p_memory, _round_up(p_size, huge));
+#else
+		aligned_free(p_memory);
+#endif
+	}
+
+	std::size_t PageAllocator::_round_up(std::size_t p_size, bool p_huge)const
+	{
+		return align_up(p_size, p_huge ? m_huge_page_size : m_page_size);
+	}
+}
\ No newline at end of file
@@ -0,0 +1,247 @@
+//! \copyright Mozilla Public License Version 2.0
+//! \note [License]		 license/license.txt
+//! \note [Contributors] license/contributors.txt
+
+// Header
+#include <entity/ssa_archetype.hpp>
+
+// C++ STD
+#include <algorithm>
+#include <cstring>
+#include <cassert>
+
+// ssa
+#include <entity/ssa_entity.hpp>
+
+namespace ssa
+{
+	Archetype::Archetype(const signature_t& p_signature, const ComponentLayout* p_layouts, Allocator& p_allocator, std::size_t p_chunk_bytes) :
+		m_signature{ p_signature },
+		m_chunk_bytes{ p_chunk_bytes },
+		m_chunk_alignment{ default_alignment },
+		m_rows_per_chunk{ 0 },
+		m_size{ 0 },
+		m_high_water{ 0 },
+		m_grow_count{ 0 },
+		m_allocator{ &p_allocator }
+	{
+		assert(m_signature.any());
+
+		std::size_t row_bytes = 0;
+		for (std::size_t type = m_signature.find_first(); type < signature_t::bit_count; type = m_signature.find_next(type + 1))
+		{
+			Column column;
+			column.type = type;
+			column.offset = 0;
+			column.stride = align_up(p_layouts[type].size, p_layouts[type].alignment);
+			column.layout = p_layouts[type];
+			column.first_field = m_field_offsets.size();
+
+			m_column_index.resize(type + 1);
+			m_column_index[type] = static_cast<std::uint16_t>(m_columns.size());
+			m_columns.push_back(column);
+
+			row_bytes += column.stride;
+			m_chunk_alignment = std::max(m_chunk_alignment, p_layouts[type].alignment);
+
+			for (std::size_t field = 0; field < column.layout.field_count; ++field)
+			{
+				m_field_offsets.push_back(0);
+				row_bytes += column.layout.fields[field].size;
+			}
+			if (column.layout.field_count != 0)
+				m_chunk_alignment = std::max(m_chunk_alignment, column.layout.field_alignment);
+		}
+
+		// Fitting as many rows as possible, columns are aligned so some padding might be needed between them
+		m_rows_per_chunk = std::max<std::size_t>(m_chunk_bytes / row_bytes, 1);
+		while (true)
+		{
+			std::size_t offset = 0;
+			for (auto& column : m_columns)
+			{
+				offset = align_up(offset, column.layout.alignment);
+				column.offset = offset;
+				offset += column.stride * m_rows_per_chunk;
+
+				// Field columns follow the headers
+				for (std::size_t field = 0; field < column.layout.field_count; ++field)
+				{
+					offset = align_up(offset, column.layout.field_alignment);
+					m_field_offsets[column.first_field + field] = offset;
+					offset += column.layout.fields[field].size * m_rows_per_chunk;
+				}
+			}
+
+			if (offset <= m_chunk_bytes || m_rows_per_chunk == 1)
+			{
+				m_chunk_bytes = std::max(m_chunk_bytes, offset);
+				break;
+			}
+			--m_rows_per_chunk;
+		}
+	}
+
+	Archetype::~Archetype()
+	{
+		for (std::size_t row = 0; row < m_size; ++row)
+		{
+			for (const auto& column : m_columns)
+				_destroy(column.layout, get_element_ptr(row, column.type));
+		}
+
+		for (auto chunk : m_chunks)
+			m_allocator->deallocate(chunk, m_chunk_bytes);
+	}
+
+	std::size_t Archetype::add_rows(std::size_t p_count)
+	{
+		while (m_size + p_count > m_chunks.size() * m_rows_per_chunk)
+		{
+			uint8_t* chunk = static_cast<uint8_t*>(m_allocator->allocate(m_chunk_bytes, m_chunk_alignment));
+			assert(chunk != nullptr);
+			m_chunks.push_back(chunk);
+			++m_grow_count;
+		}
+
+		const std::size_t first = m_size;
+		m_size += p_count;
+		m_high_water = std::max(m_high_water, m_size);
+		return first;
+	}
+
+	std::size_t Archetype::migrate_row(Archetype& p_source, std::size_t p_row)
+	{
+		assert(&p_source != this && p_row < p_source.get_size());
+
+		Entity* entity = p_source.get_entity(p_row);
+		const std::size_t row = add_row();
+		for (const auto& column : p_source.m_columns)
+		{
+			uint8_t* source = p_source.get_element_ptr(p_row, column.type);
+			if (m_signature.test(static_cast<std::size_t>(column.type)))
+			{
+				_relocate(column.layout, get_element_ptr(row, column.type), source);
+				if (column.layout.field_count != 0)
+					_move_fields(_get_column(column.type), row, p_source, p_row);
+				_link(row, column.type);
+			}
+			else
+			{
+				entity->add_component(nullptr, column.type);
+				_destroy(column.layout, source);
+			}
+		}
+
+		p_source._erase_row(p_row);
+
+		entity->m_archetype = this;
+		entity->m_row = row;
+		return row;
+	}
+
+	void Archetype::remove_row(std::size_t p_row)
+	{
+		assert(p_row < m_size);
+
+		Entity* entity = get_entity(p_row);
+		for (const auto& column : m_columns)
+		{
+			entity->add_component(nullptr, column.type);
+			_destroy(column.layout, get_element_ptr(p_row, column.type));
+		}
+
+		_erase_row(p_row);
+
+		entity->m_archetype = nullptr;
+		entity->m_row = 0;
+	}
+
+	void Archetype::shrink()
+	{
+		const std::size_t used_chunks = (m_size + m_rows_per_chunk - 1) / m_rows_per_chunk;
+		for (std::size_t chunk = used_chunks; chunk < m_chunks.size(); ++chunk)
+			m_allocator->deallocate(m_chunks[chunk], m_chunk_bytes);
+		m_chunks.resize(used_chunks);
+	}
+
+	PoolStats Archetype::get_stats()const
+	{
+		std::size_t row_bytes = 0;
+		for (const auto& column : m_columns)
+		{
+			row_bytes += column.stride;
+			for (std::size_t field = 0; field < column.layout.field_count; ++field)
+				row_bytes += column.layout.fields[field].size;
+		}
+
+		PoolStats stats;
+		stats.capacity = m_chunks.size() * m_rows_per_chunk;
+		stats.live = m_size;
+		stats.high_water = m_high_water;
+		stats.bytes_reserved = m_chunks.size() * m_chunk_bytes;
+		stats.bytes_used = m_size * row_bytes;
+		stats.grow_events = m_grow_count;
+		stats.free_list_length = stats.capacity - stats.live; // No free list, rows past the last one are free
+		return stats;
+	}
+
+	void Archetype::_erase_row(std::size_t p_row)
+	{
+		const std::size_t last = m_size - 1;
+		if (p_row != last)
+		{
+			for (const auto& column : m_columns)
+			{
+				_relocate(column.layout, get_element_ptr(p_row, column.type), get_element_ptr(last, column.type));
+				if (column.layout.field_count != 0)
+					_move_fields(column, p_row, *this, last);
+				_link(p_row, column.type);
+			}
+			get_entity(p_row)->m_row = p_row;
+		}
+
+		--m_size;
+	}
+
+	void Archetype::scatter_fields(std::size_t p_row, Component::type_t p_type, const void* p_component)
+	{
+		const ComponentLayout& layout = _get_column(p_type).layout;
+		for (std::size_t field = 0; field < layout.field_count; ++field)
+		{
+			std::memcpy(get_field_ptr(p_row, p_type, field), static_cast<const uint8_t*>(p_component) + layout.fields[field].offset, 
+				layout.fields[field].size);
+		}
+	}
+
+	void Archetype::_move_fields(const Column& p_column, std::size_t p_row, const Archetype& p_source, std::size_t p_source_row)
+	{
+		// Split types are trivially copyable
+		for (std::size_t field = 0; field < p_column.layout.field_count; ++field)
+		{
+			std::memcpy(get_field_ptr(p_row, p_column.type, field), p_source.get_field_ptr(p_source_row, p_column.type, field), 
+				p_column.layout.fields[field].size);
+		}
+	}
+
+	void Archetype::_relocate(const ComponentLayout& p_layout, uint8_t* p_destination, uint8_t* p_source)
+	{
+		if (p_layout.traits.relocate != nullptr)
+			p_layout.traits.relocate(p_destination, p_source);
+		else
+			std::memcpy(p_destination, p_source, p_layout.size);
+	}
+
+	void Archetype::_destroy(const ComponentLayout& p_layout, uint8_t* p_object)
+	{
+		if (p_layout.traits.destroy != nullptr)
+			p_layout.traits.destroy(p_object);
+	}
+
+	void Archetype::_link(std::size_t p_row, Component::type_t p_type)
+	{
+		Component* component = get_component(p_row, p_type);
+		component->m_id = p_row;
+		component->get_entity()->add_component(component, p_type);
+	}
+}
\ No newline at end of file
@@ -0,0 +1,125 @@
+//! \copyright Mozilla Public License Version 2.0
+//! \note [License]		 license/license.txt
+//! \note [Contributors] license/contributors.txt
+
+// Header
+#include <entity/ssa_command_buffer.hpp>
+
+// ssa
+#include <entity/ssa_entity_factory.hpp>
+
+namespace ssa
+{
+	namespace
+	{
+		// Arguments of a few hundred components fit without falling back to the heap
+		const std::size_t payload_capacity{ 16 * 1024 };
+	}
+
+	CommandBuffer::CommandBuffer(Allocator& p_allocator) :
+		m_create_count{ 0 },
+		m_payloads{ payload_capacity, false, p_allocator }
+	{
+	}
+
+	CommandBuffer::~CommandBuffer()
+	{
+		clear();
+	}
+
+	CommandBuffer::DeferredEntity CommandBuffer::create()
+	{
+		DeferredEntity entity;
+		entity.index = m_create_count++;
+		_push(CommandType::Create, _deferred_target(entity), true);
+		return entity;
+	}
+
+	void CommandBuffer::destroy(EntityId p_entity)
+	{
+		_push(CommandType::Destroy, p_entity, false);
+	}
+
+	void CommandBuffer::destroy(DeferredEntity p_entity)
+	{
+		_push(CommandType::Destroy, _deferred_target(p_entity), true);
+	}
+
+	void CommandBuffer::playback(EntityFactory& p_entity_factory, ComponentFactory& p_component_factory)
+	{
+		if (m_commands.empty())
+			return;
+
+		p_entity_factory.reserve(m_create_count);
+		for (const auto& reservation : m_reservations)
+			reservation.reserve(p_component_factory, reservation.count);
+
+		m_created.resize(m_create_count);
+		for (auto& command : m_commands)
+		{
+			if (command.type == CommandType::Create)
+			{
+				m_created[command.target.index] = p_entity_factory.get_id(p_entity_factory.create_entity());
+				continue;
+			}
+
+			const EntityId target = command.deferred ? m_created[command.target.index] : command.target;
+			Entity* entity = p_entity_factory.resolve(target);
+			if (entity != nullptr)
+			{
+				if (command.type == CommandType::Destroy)
+				{
+					p_entity_factory.remove_entity(*entity);
+				}
+				else
+				{
+					EntityHandle handle(*entity, p_entity_factory, p_component_factory);
+					command.apply(p_component_factory, handle, command.payload);
+				}
+			}
+
+			if (command.destroy != nullptr)
+			{
+				command.destroy(command.payload);
+				command.destroy = nullptr;
+			}
+		}
+
+		m_created.clear();
+		clear();
+	}
+
+	void CommandBuffer::clear()
+	{
+		for (auto& command : m_commands)
+		{
+			if (command.destroy != nullptr)
+				command.destroy(command.payload);
+		}
+
+		m_commands.clear();
+		m_reservations.clear();
+		m_create_count = 0;
+		m_payloads.reset();
+	}
+
+	void CommandBuffer::_push(CommandType p_type, EntityId p_target, bool p_deferred, apply_t p_apply, destroy_t p_destroy, void* p_payload)
+	{
+		Command command;
+		command.type = p_type;
+		command.deferred = p_deferred;
+		command.target = p_target;
+		command.apply = p_apply;
+		command.destroy = p_destroy;
+		command.payload = p_payload;
+		m_commands.push_back(command);
+	}
+
+	EntityId CommandBuffer::_deferred_target(DeferredEntity p_entity)
+	{
+		EntityId id;
+		id.index = p_entity.index;
+		id.generation = 0;
+		return id;
+	}
+}
\ No newline at end of file
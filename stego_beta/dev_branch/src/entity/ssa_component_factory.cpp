@@ -4,18 +4,393 @@
 
 // Header
 #include <entity/ssa_component_factory.hpp>
+#include <entity/ssa_entity.hpp>
+#include <entity/ssa_entity_factory.hpp>
+#include <entity/ssa_prefab.hpp>
+#include <core/ssa_binary_stream.hpp>
+
+// C++ STD
+#include <algorithm>
 
 namespace ssa
 {
-	ComponentFactory::ComponentFactory() :
-		m_last_type{ 0 }
+	ComponentFactory::ComponentFactory(Allocator& p_allocator) :
+		m_last_type{ 0 },
+		m_concurrent{ false },
+		m_allocator{ &p_allocator },
+		m_storage_mode{ StorageMode::Pools },
+		m_change_tick{ 1 }
+	{
+	}
+
+	ComponentFactory::~ComponentFactory()
 	{
+		// Bags destroy the components they still hold
 		for (auto& bag : m_components)
+		{
+			delete bag;
 			bag = nullptr;
+		}
+
+		for (auto archetype : m_archetypes)
+			delete archetype;
+		m_archetypes.clear();
+		m_archetype_map.clear();
 	}
 
-	ComponentFactory::~ComponentFactory()
+	void ComponentFactory::remove_observer(EntityObserver* p_observer)
+	{
+		m_observers.erase(std::remove(m_observers.begin(), m_observers.end(), p_observer), m_observers.end());
+	}
+
+	void ComponentFactory::set_storage_mode(StorageMode p_mode)
+	{
+		assert(m_last_type == 0);
+		m_storage_mode = p_mode;
+	}
+
+	void ComponentFactory::set_concurrent(bool p_concurrent)
+	{
+		// Moving entities between tables is not synchronized
+		assert(!p_concurrent || m_storage_mode == StorageMode::Pools);
+
+		m_concurrent = p_concurrent;
+		for (std::size_t type = 0; type < m_last_type; ++type)
+		{
+			if (m_components[type] != nullptr)
+				m_components[type]->set_concurrent(p_concurrent);
+		}
+	}
+
+	std::size_t ComponentFactory::get_live_count(Component::type_t p_type)const
+	{
+		const std::size_t type = static_cast<std::size_t>(p_type);
+		if (m_storage_mode == StorageMode::Pools)
+			return static_cast<std::size_t>(m_components[type]->get_size());
+
+		std::size_t count = 0;
+		for (auto archetype : m_archetypes)
+		{
+			if (archetype->get_signature().test(type))
+				count += archetype->get_size();
+		}
+		return count;
+	}
+
+	void ComponentFactory::get_pool_stats(pool_stats_list_t& p_stats)const
 	{
+		if (m_storage_mode == StorageMode::Archetypes)
+		{
+			// Tables are named after the component types they store
+			for (auto archetype : m_archetypes)
+			{
+				std::string name = "archetype";
+				for (std::size_t type = 0; type < m_last_type; ++type)
+				{
+					if (archetype->get_signature().test(type))
+						name += " " + m_type_names[type];
+				}
+				p_stats.push_back(std::make_pair(name, archetype->get_stats()));
+			}
+			return;
+		}
+
+		for (std::size_t type = 0; type < m_last_type; ++type)
+			p_stats.push_back(std::make_pair("component " + m_type_names[type], m_components[type]->get_stats()));
+	}
+
+	bool ComponentFactory::write_snapshot(std::ostream& p_stream)const
+	{
+		// Tables are not supported
+		if (m_storage_mode != StorageMode::Pools)
+			return false;
+
+		for (std::size_t type = 0; type < m_last_type; ++type)
+		{
+			if (!m_components[type]->is_trivially_copyable())
+				return false;
+		}
+
+		if (!write_binary(p_stream, static_cast<std::uint64_t>(m_last_type)))
+			return false;
+
+		for (std::size_t type = 0; type < m_last_type; ++type)
+		{
+			if (!write_binary(p_stream, m_type_names[type]) || !m_components[type]->write_snapshot(p_stream))
+				return false;
+		}
+
+		return true;
+	}
+
+	bool ComponentFactory::read_snapshot(std::istream& p_stream, EntityFactory& p_entity_factory, const Bag::SnapshotLayout& p_entity_layout)
+	{
+		if (m_storage_mode != StorageMode::Pools)
+			return false;
+
+		std::uint64_t type_count;
+		if (!read_binary(p_stream, type_count) || type_count > m_last_type)
+			return false;
+
+		std::vector<bool> restored(m_last_type, false);
+
+		for (std::size_t i = 0; i < type_count; ++i)
+		{
+			// Types are matched by name, registration order might differ from the one at save time
+			std::string name;
+			if (!read_binary(p_stream, name))
+				return false;
+
+			const auto type = static_cast<std::size_t>(std::find(m_type_names.begin(), m_type_names.begin() + m_last_type, name) - m_type_names.begin());
+			if (type == m_last_type || restored[type])
+				return false;
+
+			Bag& bag = *m_components[type];
+			if (!bag.read_snapshot(p_stream))
+				return false;
+			restored[type] = true;
+
+			// Entities are at the same indices they had when saved, translating the old addresses
+			bool linked = true;
+			bag.for_each([&](Bag::index_t p_index)
+			{
+				Component& component = bag.get_object<Component>(p_index);
+				const Bag::index_t entity_id = p_entity_layout.find(component.m_entity);
+				if (entity_id == Bag::npos)
+				{
+					linked = false;
+					return;
+				}
+
+				component.m_type = type;
+				component.m_entity = &p_entity_factory.get_entity(entity_id);
+				component.m_entity->add_component(&component, type);
+			});
+
+			if (!linked)
+				return false;
+		}
+
+		// Types not in the snapshot had components linked to entities that do not exist anymore
+		for (std::size_t type = 0; type < m_last_type; ++type)
+		{
+			if (restored[type])
+				continue;
+
+			Bag& bag = *m_components[type];
+			bag.for_each([&](Bag::index_t p_index) { bag.recycle(p_index); });
+		}
+
+		return true;
+	}
+
+	void ComponentFactory::compact()
+	{
+		// Tables are always dense, only the empty chunks have to go
+		for (auto archetype : m_archetypes)
+			archetype->shrink();
+
+		for (std::size_t type = 0; type < m_last_type; ++type)
+		{
+			Bag* bag = m_components[type];
+			if (bag == nullptr)
+				continue;
+
+			const Bag::remap_t remap = bag->compact();
+			for (const auto& relocation : remap)
+			{
+				Component& component = bag->get_object<Component>(relocation.to);
+				component.m_id = relocation.to;
+				component.m_entity->add_component(&component, type);
+			}
+		}
+	}
+
+	Archetype& ComponentFactory::_get_archetype(const Archetype::signature_t& p_signature)
+	{
+		auto find_res = m_archetype_map.find(p_signature);
+		if (find_res != m_archetype_map.end())
+			return *find_res->second;
+
+		Archetype* archetype = new Archetype(p_signature, m_layouts.data(), *m_allocator);
+		m_archetype_map[p_signature] = archetype;
+		m_archetypes.push_back(archetype);
+		return *archetype;
+	}
+
+	std::size_t ComponentFactory::_move_entity(Entity& p_entity, Archetype& p_archetype)
+	{
+		if (p_entity.m_archetype != nullptr)
+			return p_archetype.migrate_row(*p_entity.m_archetype, p_entity.m_row);
+
+		// First component of the entity
+		const std::size_t row = p_archetype.add_row();
+		p_entity.m_archetype = &p_archetype;
+		p_entity.m_row = row;
+		return row;
+	}
+
+	void ComponentFactory::_detach_component(Entity& p_entity, Component::type_t p_type)
+	{
+		if (m_storage_mode == StorageMode::Pools)
+		{
+			Bag& bag = *m_components[static_cast<std::size_t>(p_type)];
+			bag.recycle(p_entity.get_component_ptr(p_type)->get_id());
+			p_entity.add_component(nullptr, p_type);
+		}
+		else
+		{
+			// Moving the entity to the table with one column less, or out of any table if it was the last component
+			Archetype::signature_t signature = p_entity.m_archetype->get_signature();
+			signature.reset(static_cast<std::size_t>(p_type));
+			if (signature.none())
+				p_entity.m_archetype->remove_row(p_entity.m_row);
+			else
+				_get_archetype(signature).migrate_row(*p_entity.m_archetype, p_entity.m_row);
+		}
+
+		for (auto observer : m_observers)
+			observer->on_component_detached(p_entity, p_type);
+	}
+
+	void ComponentFactory::instantiate(const Prefab& p_prefab, Entity* const* p_entities, std::size_t p_count)
+	{
+		if (p_count == 0 || p_prefab.m_entries.empty())
+			return;
+
+		std::vector<Component::type_t> types(p_prefab.m_entries.size());
+		const std::uint32_t tick = get_change_tick();
+		Component::signature_t signature;
+		for (std::size_t e = 0; e < p_prefab.m_entries.size(); ++e)
+		{
+			types[e] = p_prefab.m_entries[e].register_type(*this);
+			signature.set(static_cast<std::size_t>(types[e]));
+		}
+
+		if (m_storage_mode == StorageMode::Archetypes)
+		{
+			for (std::size_t i = 0; i < p_count; ++i)
+				assert(p_entities[i]->m_archetype == nullptr);
+
+			Archetype& archetype = _get_archetype(signature);
+			const std::size_t first = archetype.add_rows(p_count);
+			const std::size_t rows_per_chunk = archetype.get_rows_per_chunk();
+
+			for (std::size_t e = 0; e < p_prefab.m_entries.size(); ++e)
+			{
+				const auto& entry = p_prefab.m_entries[e];
+				const Component::type_t type = types[e];
+				const std::size_t stride = archetype.get_column_stride(type);
+
+				if (archetype.is_split(type))
+				{
+					// Headers in the column, values in the field columns
+					for (std::size_t i = 0; i < p_count; ++i)
+					{
+						new (archetype.get_element_ptr(first + i, type)) Component();
+						archetype.scatter_fields(first + i, type, entry.prototype);
+					}
+				}
+				else
+				{
+					// Columns are contiguous inside a chunk
+					for (std::size_t row = first; row < first + p_count;)
+					{
+						const std::size_t end = std::min(first + p_count, (row / rows_per_chunk + 1) * rows_per_chunk);
+						entry.clone(*entry.prototype, archetype.get_element_ptr(row, type), end - row, stride);
+						row = end;
+					}
+				}
+
+				for (std::size_t i = 0; i < p_count; ++i)
+				{
+					Component* component = archetype.get_component(first + i, type);
+					component->m_type = type;
+					component->m_id = first + i;
+					component->m_entity = p_entities[i];
+					component->m_version = tick;
+					p_entities[i]->add_component(component, type);
+				}
+			}
+
+			for (std::size_t i = 0; i < p_count; ++i)
+			{
+				p_entities[i]->m_archetype = &archetype;
+				p_entities[i]->m_row = first + i;
+			}
+		}
+		else
+		{
+			for (std::size_t e = 0; e < p_prefab.m_entries.size(); ++e)
+			{
+				const auto& entry = p_prefab.m_entries[e];
+				const Component::type_t type = types[e];
+				Bag& bag = *m_components[static_cast<std::size_t>(type)];
+				bag.reserve(p_count);
+
+				for (std::size_t i = 0; i < p_count; ++i)
+				{
+					assert(!p_entities[i]->has_component(type));
+
+					Component::id_t id;
+					Component* component = entry.emplace(bag, *entry.prototype, id);
+					component->m_type = type;
+					component->m_id = id;
+					component->m_entity = p_entities[i];
+					component->m_version = tick;
+					p_entities[i]->add_component(component, type);
+				}
+			}
+		}
+
+		if (m_observers.empty())
+			return;
+
+		for (std::size_t i = 0; i < p_count; ++i)
+		{
+			signature.for_each([&](std::size_t p_type)
+			{
+				for (auto observer : m_observers)
+					observer->on_component_attached(*p_entities[i], p_type);
+			});
+		}
+	}
+
+	std::size_t ComponentFactory::get_field_index(Component::type_t p_type, std::size_t p_offset)const
+	{
+		const ComponentLayout& layout = m_layouts[static_cast<std::size_t>(p_type)];
+		for (std::size_t field = 0; field < layout.field_count; ++field)
+		{
+			if (layout.fields[field].offset == p_offset)
+				return field;
+		}
+		return max_component_fields;
+	}
+
+	void ComponentFactory::_detach_all(Entity& p_entity)
+	{
+		const Component::signature_t signature = p_entity.get_signature();
+		if (signature.none())
+			return;
+
+		if (m_storage_mode == StorageMode::Pools)
+		{
+			signature.for_each([&](std::size_t p_type)
+			{
+				m_components[p_type]->recycle(p_entity.get_component_ptr(p_type)->get_id());
+				p_entity.add_component(nullptr, p_type);
+			});
+		}
+		else
+		{
+			// Every column at once, no intermediate tables
+			p_entity.m_archetype->remove_row(p_entity.m_row);
+		}
 
+		signature.for_each([&](std::size_t p_type)
+		{
+			for (auto observer : m_observers)
+				observer->on_component_detached(p_entity, p_type);
+		});
 	}
 }
\ No newline at end of file
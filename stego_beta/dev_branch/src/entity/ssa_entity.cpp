@@ -5,14 +5,24 @@
 // Header
 #include <entity/ssa_entity.hpp>
 
+// C++ STD
+#include <cstring>
+#include <cassert>
+#include <type_traits>
+
 namespace ssa
 {
 	Entity::Entity() :
-		ref_count{ 0 },
-		id{ 0 }
+		id{ 0 },
+		m_overflow{ nullptr },
+		m_component_count{ 0 },
+		m_overflow_capacity{ 0 },
+		m_allocator{ &get_default_allocator() },
+		m_archetype{ nullptr },
+		m_row{ 0 }
 	{
 		// ODIO Visual Studio, default per i puntatori non e' 0x0000, ma 0x0c0c0c0 o qualche porcata simile , neanche gargabe
-		std::memset(m_components, 0, sizeof(Component*)* Component::max_component_number);
+		std::memset(m_inline, 0, sizeof(Component*)* inline_components);
 	}
 
 	Entity::~Entity()
@@ -21,14 +31,69 @@ namespace ssa
 
 	void Entity::add_component(Component* c, Component::type_t type)
 	{
-		//TODO when manager manager is ready
-		m_components[type] = c;
+		const std::size_t slot = m_signature.rank(static_cast<std::size_t>(type));
+		Component** slots = _get_slots();
+
+		if (m_signature.test(static_cast<std::size_t>(type)))
+		{
+			if (c != nullptr)
+			{
+				slots[slot] = c;
+				return;
+			}
+
+			std::memmove(slots + slot, slots + slot + 1, sizeof(Component*) * (m_component_count - slot - 1));
+			slots[--m_component_count] = nullptr;
+			m_signature.reset(static_cast<std::size_t>(type));
+			return;
+		}
+
+		if (c == nullptr)
+			return;
+
+		const std::size_t capacity = m_overflow != nullptr ? m_overflow_capacity : inline_components;
+		if (m_component_count == capacity)
+		{
+			// Doubling, the pointers move to the new block and m_inline is left unused
+			assert(m_allocator != nullptr);
+			const std::size_t new_capacity = capacity * 2;
+			Component** block = static_cast<Component**>(m_allocator->allocate(sizeof(Component*) * new_capacity, std::alignment_of<Component*>::value));
+			std::memcpy(block, slots, sizeof(Component*) * m_component_count);
+
+			if (m_overflow != nullptr)
+				m_allocator->deallocate(m_overflow, sizeof(Component*) * m_overflow_capacity);
+			m_overflow = block;
+			m_overflow_capacity = static_cast<std::uint32_t>(new_capacity);
+			slots = block;
+		}
+
+		std::memmove(slots + slot + 1, slots + slot, sizeof(Component*) * (m_component_count - slot));
+		slots[slot] = c;
+		++m_component_count;
+		m_signature.set(static_cast<std::size_t>(type));
 	}
 
 	bool Entity::has_component(Component::type_t p_type)
 	{
-		if (m_components[static_cast<std::size_t>(p_type)] == nullptr)
-			return false;
-		return true;
+		return m_signature.test(static_cast<std::size_t>(p_type));
+	}
+
+	void Entity::_release()
+	{
+		if (m_overflow != nullptr)
+			m_allocator->deallocate(m_overflow, sizeof(Component*) * m_overflow_capacity);
+		m_overflow = nullptr;
+		m_overflow_capacity = 0;
+		m_component_count = 0;
+		m_signature.clear();
+		std::memset(m_inline, 0, sizeof(Component*)* inline_components);
+	}
+
+	void Entity::_reset(Allocator& p_allocator)
+	{
+		m_overflow = nullptr;
+		m_overflow_capacity = 0;
+		m_allocator = &p_allocator;
+		_release();
 	}
 }
\ No newline at end of file
@@ -5,21 +5,68 @@
 // Header
 #include <entity/ssa_entity_factory.hpp>
 
+// C++ STD
+#include <algorithm>
+#include <cassert>
+#include <new>
+#include <type_traits>
+
 namespace ssa
 {
-	EntityFactory::EntityFactory() :
-		m_entities(sizeof(Entity), 50)
+	EntityFactory::EntityFactory(Allocator& p_allocator) :
+		m_entities(sizeof(Entity), 50, Bag::default_page_size, std::alignment_of<Entity>::value, p_allocator),
+		m_generation_pages{ new std::atomic<std::atomic<std::uint32_t>*>[max_generation_pages]() }
+	{
+	}
+
+	EntityFactory::~EntityFactory()
 	{
+		m_entities.for_each([&](Bag::index_t p_index)
+		{
+			m_entities.get_object<Entity>(p_index)._release();
+		});
+
+		Allocator& allocator = m_entities.get_allocator();
+		for (std::size_t page = 0; page < max_generation_pages; ++page)
+		{
+			std::atomic<std::uint32_t>* generations = m_generation_pages[page].load();
+			if (generations != nullptr)
+				allocator.deallocate(generations, sizeof(std::atomic<std::uint32_t>) * generation_page_size);
+		}
 	}
 
 	Entity& EntityFactory::create_entity()
 	{
 		Entity::id_t id = m_entities.add_object<Entity>();
+		_reserve_generation(id);
+
 		Entity& new_entity = m_entities.get_object<Entity>(id);
 		new_entity.id = id;
+		new_entity.m_allocator = &m_entities.get_allocator();
 		return new_entity;
 	}
 
+	EntityId EntityFactory::get_id(const Entity& p_entity)const
+	{
+		EntityId id;
+		id.index = static_cast<std::uint32_t>(p_entity.id);
+		id.generation = _generation(p_entity.id).load(std::memory_order_acquire);
+		return id;
+	}
+
+	bool EntityFactory::is_valid(EntityId p_id)const
+	{
+		const std::size_t page = static_cast<std::size_t>(p_id.index / generation_page_size);
+		if (page >= max_generation_pages || m_generation_pages[page].load(std::memory_order_acquire) == nullptr)
+			return false;
+		return _generation(p_id.index).load(std::memory_order_acquire) == p_id.generation && m_entities.is_occupied(p_id.index);
+	}
+
+	Entity* EntityFactory::resolve(EntityId p_id)
+	{
+		return is_valid(p_id) ? &m_entities.get_object<Entity>(p_id.index) : nullptr;
+	}
+
 	Entity& EntityFactory::get_entity(Entity::id_t p_id)
 	{
 		return m_entities.get_object<Entity>(p_id);
@@ -27,8 +74,95 @@ namespace ssa
 
 	void EntityFactory::remove_entity(Entity& p_entity)
 	{
-		p_entity.ref_count--;
-		if (p_entity.ref_count <= 0)
-			m_entities.recycle(p_entity.id);
+		for (auto observer : m_observers)
+			observer->on_entity_removed(p_entity);
+
+		// Ids taken until now do not match anymore
+		_generation(p_entity.id).fetch_add(1, std::memory_order_acq_rel);
+		p_entity._release();
+		m_entities.recycle(p_entity.id);
+	}
+
+	void EntityFactory::remove_observer(EntityObserver* p_observer)
+	{
+		m_observers.erase(std::remove(m_observers.begin(), m_observers.end(), p_observer), m_observers.end());
+	}
+
+	bool EntityFactory::read_snapshot(std::istream& p_stream, Bag::SnapshotLayout& p_layout)
+	{
+		// Overflow blocks of the current entities, the Bag drops its content without running any destructor
+		std::vector<Entity> current;
+		std::vector<Entity::id_t> used;
+		m_entities.for_each([&](Bag::index_t p_index)
+		{
+			const Entity& entity = m_entities.get_object<Entity>(p_index);
+			used.push_back(entity.id);
+			if (entity.m_overflow != nullptr)
+				current.push_back(entity);
+		});
+
+		if (!m_entities.read_snapshot(p_stream, &p_layout))
+			return false;
+
+		for (auto& entity : current)
+			entity._release();
+
+		// Ids taken before the load do not match anymore, neither the removed entities nor the ones replaced in their slot
+		for (auto id : used)
+			_generation(id).fetch_add(1, std::memory_order_acq_rel);
+
+		// Component pointers are stale and no handle is referencing the restored entities
+		m_entities.for_each([&](Bag::index_t p_index)
+		{
+			Entity& entity = m_entities.get_object<Entity>(p_index);
+			_reserve_generation(entity.id);
+			_generation(entity.id).fetch_add(1, std::memory_order_acq_rel);
+			entity._reset(m_entities.get_allocator());
+		});
+
+		return true;
+	}
+
+	void EntityFactory::compact()
+	{
+		const Bag::remap_t remap = m_entities.compact();
+		for (const auto& relocation : remap)
+		{
+			Entity& entity = m_entities.get_object<Entity>(relocation.to);
+			entity.id = relocation.to;
+
+			// The slot left behind is a removed entity, the new one continues with its own generation
+			_generation(relocation.from).fetch_add(1);
+
+			entity.for_each_component([&](Component* p_component)
+			{
+				p_component->m_entity = &entity;
+			});
+		}
+	}
+
+	std::atomic<std::uint32_t>& EntityFactory::_generation(Entity::id_t p_index)const
+	{
+		const std::size_t page = static_cast<std::size_t>(p_index / generation_page_size);
+		return m_generation_pages[page].load(std::memory_order_acquire)[static_cast<std::size_t>(p_index % generation_page_size)];
+	}
+
+	void EntityFactory::_reserve_generation(Entity::id_t p_index)
+	{
+		assert(p_index < max_entities);
+
+		const std::size_t page = static_cast<std::size_t>(p_index / generation_page_size);
+		if (m_generation_pages[page].load(std::memory_order_acquire) != nullptr)
+			return;
+
+		std::lock_guard<std::mutex> lock(m_generation_mutex);
+		if (m_generation_pages[page].load(std::memory_order_relaxed) != nullptr)
+			return;
+
+		void* memory = m_entities.get_allocator().allocate(sizeof(std::atomic<std::uint32_t>) * generation_page_size, default_alignment);
+		std::atomic<std::uint32_t>* generations = static_cast<std::atomic<std::uint32_t>*>(memory);
+		for (std::size_t i = 0; i < generation_page_size; ++i)
+			new (generations + i) std::atomic<std::uint32_t>(0);
+		m_generation_pages[page].store(generations, std::memory_order_release);
 	}
 }
\ No newline at end of file
@@ -5,30 +5,124 @@
 // Header
 #include <entity/ssa_entity_framework_api.hpp>
 
+// ssa
+#include <core/ssa_binary_stream.hpp>
+
 namespace ssa
 {
-	EntityFrameworkAPI::EntityFrameworkAPI() : 
-		m_entity_factory{},
-		m_component_factory{},
-		m_system_looper{ m_entity_factory, m_component_factory }
+	namespace
 	{
+		// Written at the beginning of every snapshot ( "SSAW" ) followed by the version
+		const std::uint32_t snapshot_magic{ 0x57415353 };
+		const std::uint32_t snapshot_version{ 1 };
+	}
 
+	EntityFrameworkAPI::EntityFrameworkAPI(Allocator& p_allocator) : 
+		m_entity_factory{ p_allocator },
+		m_component_factory{ p_allocator },
+		m_system_looper{ m_entity_factory, m_component_factory }
+	{
+		// Components of removed entities are destroyed with them
+		m_entity_factory.add_observer(&m_component_factory);
 	}
 
 	EntityFrameworkAPI::~EntityFrameworkAPI()
 	{
+		m_entity_factory.remove_observer(&m_component_factory);
+	}
+
+	void EntityFrameworkAPI::set_concurrent(bool p_concurrent)
+	{
+		m_entity_factory.set_concurrent(p_concurrent);
+		m_component_factory.set_concurrent(p_concurrent);
+	}
+
+	pool_stats_list_t EntityFrameworkAPI::get_pool_stats()const
+	{
+		pool_stats_list_t stats;
+		stats.push_back(std::make_pair(std::string("entities"), m_entity_factory.get_stats()));
+		m_component_factory.get_pool_stats(stats);
+		return stats;
+	}
 
+	void EntityFrameworkAPI::dump_stats(std::ostream& p_stream)const
+	{
+		write_pool_stats(p_stream, get_pool_stats());
 	}
 
 	// ===== ENTITY-RELATED METHODS =====
 	EntityHandle EntityFrameworkAPI::create_entity()
 	{
-		return EntityHandle(m_entity_factory.create_entity(), m_component_factory);
+		return EntityHandle(m_entity_factory.create_entity(), m_entity_factory, m_component_factory);
+	}
+
+	EntityHandle EntityFrameworkAPI::get_entity(EntityId p_id)
+	{
+		Entity* entity = m_entity_factory.resolve(p_id);
+		if (entity == nullptr)
+			return EntityHandle();
+		return EntityHandle(*entity, m_entity_factory, m_component_factory);
+	}
+
+	void EntityFrameworkAPI::remove_entity(EntityId p_id)
+	{
+		Entity* entity = m_entity_factory.resolve(p_id);
+		if (entity != nullptr)
+			m_entity_factory.remove_entity(*entity);
+	}
+
+	void EntityFrameworkAPI::instantiate(const Prefab& p_prefab, std::size_t p_count, std::vector<EntityId>* p_ids)
+	{
+		m_entity_factory.reserve(p_count);
+
+		m_instances.resize(p_count);
+		for (std::size_t i = 0; i < p_count; ++i)
+			m_instances[i] = &m_entity_factory.create_entity();
+
+		m_component_factory.instantiate(p_prefab, m_instances.data(), p_count);
+
+		if (p_ids != nullptr)
+		{
+			p_ids->reserve(p_ids->size() + p_count);
+			for (std::size_t i = 0; i < p_count; ++i)
+				p_ids->push_back(m_entity_factory.get_id(*m_instances[i]));
+		}
+	}
+
+	void EntityFrameworkAPI::compact()
+	{
+		m_component_factory.compact();
+		m_entity_factory.compact();
+
+		// Entity ids changed
+		m_system_looper.invalidate_matches();
 	}
 
-	EntityHandle EntityFrameworkAPI::get_entity(Entity::id_t p_id)
+	bool EntityFrameworkAPI::save_snapshot(std::ostream& p_stream)const
 	{
-		return EntityHandle(m_entity_factory.get_entity(p_id), m_component_factory);
+		if (m_component_factory.get_storage_mode() != ComponentFactory::StorageMode::Pools)
+			return false;
+
+		return write_binary(p_stream, snapshot_magic) && write_binary(p_stream, snapshot_version) &&
+			m_entity_factory.write_snapshot(p_stream) && m_component_factory.write_snapshot(p_stream);
+	}
+
+	bool EntityFrameworkAPI::load_snapshot(std::istream& p_stream)
+	{
+		if (m_component_factory.get_storage_mode() != ComponentFactory::StorageMode::Pools)
+			return false;
+
+		std::uint32_t magic, version;
+		if (!read_binary(p_stream, magic) || !read_binary(p_stream, version) || magic != snapshot_magic || version != snapshot_version)
+			return false;
+
+		Bag::SnapshotLayout entity_layout;
+		const bool loaded = m_entity_factory.read_snapshot(p_stream, entity_layout) && 
+			m_component_factory.read_snapshot(p_stream, m_entity_factory, entity_layout);
+
+		// Every entity changed
+		m_system_looper.invalidate_matches();
+		return loaded;
 	}
 
 	void EntityFrameworkAPI::process()
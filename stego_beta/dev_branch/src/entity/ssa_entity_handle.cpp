@@ -5,34 +5,36 @@
 // Header
 #include <entity/ssa_entity_handle.hpp>
 #include <entity/ssa_entity.hpp>
+#include <entity/ssa_entity_factory.hpp>
+
+// C++ STD
+#include <type_traits>
 
 namespace ssa
 {
-	EntityHandle::EntityHandle(Entity& p_entity, ComponentFactory& p_component_factory) :
-		m_entity{ &p_entity },
-		m_component_factory{ &p_component_factory }
-	{
-		++m_entity->ref_count;
-	}
+	static_assert(std::is_trivially_copyable<EntityHandle>::value, "Handles are copied around by value");
+	static_assert(std::is_trivially_copyable<EntityId>::value, "Ids are copied around by value");
 
-	EntityHandle::~EntityHandle()
+	EntityHandle::EntityHandle() :
+		m_entity{ nullptr },
+		m_entity_factory{ nullptr },
+		m_component_factory{ nullptr },
+		m_id(EntityId::invalid()),
+		m_worker{ 0 }
 	{
-		--m_entity->ref_count;
 	}
 
-	EntityHandle::EntityHandle(const EntityHandle& p_other) : 
-		m_entity{ p_other.m_entity },
-		m_component_factory{ p_other.m_component_factory }
+	EntityHandle::EntityHandle(Entity& p_entity, EntityFactory& p_entity_factory, ComponentFactory& p_component_factory, std::size_t p_worker) :
+		m_entity{ &p_entity },
+		m_entity_factory{ &p_entity_factory },
+		m_component_factory{ &p_component_factory },
+		m_id(p_entity_factory.get_id(p_entity)),
+		m_worker{ p_worker }
 	{
-		++m_entity->ref_count;
 	}
 
-	EntityHandle& EntityHandle::operator=(const EntityHandle& p_other)
+	bool EntityHandle::is_valid()const
 	{
-		--m_entity->ref_count;
-		m_entity = p_other.m_entity;
-		++m_entity->ref_count;
-
-		return *this;
+		return m_entity_factory != nullptr && m_entity_factory->is_valid(m_id);
 	}
 }
\ No newline at end of file
@@ -0,0 +1,25 @@
+//! \copyright Mozilla Public License Version 2.0
+//! \note [License]		 license/license.txt
+//! \note [Contributors] license/contributors.txt
+
+// Header
+#include <entity/ssa_prefab.hpp>
+
+namespace ssa
+{
+	Prefab::~Prefab()
+	{
+		for (auto& entry : m_entries)
+			entry.destroy(entry.prototype);
+	}
+
+	Prefab::Entry* Prefab::_find(std::size_t p_type_index)
+	{
+		for (auto& entry : m_entries)
+		{
+			if (entry.type_index == p_type_index)
+				return &entry;
+		}
+		return nullptr;
+	}
+}
\ No newline at end of file
@@ -0,0 +1,113 @@
+//! \copyright Mozilla Public License Version 2.0
+//! \note [License]		 license/license.txt
+//! \note [Contributors] license/contributors.txt
+
+// Header
+#include <entity/ssa_signature.hpp>
+
+#if defined(ssa_sse2)
+#include <emmintrin.h>
+#endif
+
+namespace ssa
+{
+	std::size_t filter_signatures(const Signature* p_signatures, std::size_t p_count, 
+		const Signature& p_required, std::uint64_t* p_indices)
+	{
+		// Words of p_required with bits, the others match any signature
+		std::size_t words[Signature::word_count];
+		std::size_t word_count = 0;
+		for (std::size_t w = 0; w < Signature::word_count; ++w)
+		{
+			if (p_required.get_word(w) != 0)
+				words[word_count++] = w;
+		}
+
+		std::size_t matches = 0;
+		std::size_t i = 0;
+
+		if (word_count == 0)
+		{
+			for (; i < p_count; ++i)
+				p_indices[matches++] = i;
+			return matches;
+		}
+
+#if defined(ssa_sse2)
+		// SSE2 has no 64-bit compare, comparing 32-bit halves and requiring all of them to match
+		if (Signature::word_count == 1)
+		{
+			// Adjacent signatures are adjacent words, loading two at once
+			__m128i required = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(p_required.get_words()));
+			required = _mm_unpacklo_epi64(required, required);
+
+			for (; i + 2 <= p_count; i += 2)
+			{
+				const __m128i pair = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p_signatures[i].get_words()));
+				const __m128i equal = _mm_cmpeq_epi32(_mm_and_si128(pair, required), required);
+
+				// One bit per half, a signature matches if both its bits ( 2k, 2k + 1 ) are set
+				unsigned int bits = static_cast<unsigned int>(_mm_movemask_ps(_mm_castsi128_ps(equal)));
+				bits = bits & (bits >> 1) & 0x5;
+
+				while (bits != 0)
+				{
+					p_indices[matches++] = i + count_trailing_zeros(bits) / 2;
+					bits &= bits - 1;
+				}
+			}
+		}
+		else if (word_count > 1)
+		{
+			// Testing the words of a signature two at a time, only the pairs where p_required has bits. A single word 
+			// is as fast in the scalar loop
+			const std::size_t pair_count = Signature::word_count / 2;
+			std::size_t pairs[(Signature::word_count + 1) / 2];
+			__m128i required[(Signature::word_count + 1) / 2];
+			std::size_t required_pairs = 0;
+			for (std::size_t pair = 0; pair < pair_count; ++pair)
+			{
+				if ((p_required.get_word(2 * pair) | p_required.get_word(2 * pair + 1)) != 0)
+				{
+					pairs[required_pairs] = pair;
+					required[required_pairs++] = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p_required.get_words() + 2 * pair));
+				}
+			}
+
+			// With an odd word_count the last word has no pair, tested on its own
+			const std::size_t last = Signature::word_count - 1;
+			const Signature::word_t required_last = Signature::word_count % 2 != 0 ? p_required.get_word(last) : 0;
+
+			const __m128i all = _mm_cmpeq_epi32(_mm_setzero_si128(), _mm_setzero_si128());
+			for (; i < p_count; ++i)
+			{
+				const Signature::word_t* words = p_signatures[i].get_words();
+				__m128i equal = all;
+				for (std::size_t pair = 0; pair < required_pairs; ++pair)
+				{
+					const __m128i loaded = _mm_loadu_si128(reinterpret_cast<const __m128i*>(words + 2 * pairs[pair]));
+					equal = _mm_and_si128(equal, _mm_cmpeq_epi32(_mm_and_si128(loaded, required[pair]), required[pair]));
+				}
+
+				if (_mm_movemask_epi8(equal) == 0xffff && (words[last] & required_last) == required_last)
+					p_indices[matches++] = i;
+			}
+		}
+#endif
+
+		for (; i < p_count; ++i)
+		{
+			bool match = true;
+			for (std::size_t w = 0; w < word_count && match; ++w)
+			{
+				const Signature::word_t required_word = p_required.get_word(words[w]);
+				match = (p_signatures[i].get_word(words[w]) & required_word) == required_word;
+			}
+
+			if (match)
+				p_indices[matches++] = i;
+		}
+
+		return matches;
+	}
+}
\ No newline at end of file
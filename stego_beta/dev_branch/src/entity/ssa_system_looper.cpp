@@ -8,69 +8,477 @@
 // ssa
 #include <entity/ssa_entity_factory.hpp>
 #include <entity/ssa_component_factory.hpp>
+#include <entity/ssa_signature.hpp>
+
+// C++ STD
+#include <algorithm>
 
 namespace ssa
 {
 	SystemLooper::SystemLooper(EntityFactory& p_entity_factory,
 		ComponentFactory& p_component_factory) :
+		m_stage{ 0 },
 		m_entity_factory{ &p_entity_factory },
-		m_component_factory{ &p_component_factory }
+		m_component_factory{ &p_component_factory },
+		m_pending_count{ 0 },
+		m_first_node{ 0 }
 	{
+		m_command_buffers.emplace_back(new CommandBuffer());
 
+		m_entity_factory->add_observer(this);
+		m_component_factory->add_observer(this);
 	}
 
 	SystemLooper::~SystemLooper()
 	{
+		m_entity_factory->remove_observer(this);
+		m_component_factory->remove_observer(this);
 
+		for (auto system : m_systems)
+			delete system;
 	}
 
 	void SystemLooper::process()
 	{
-		for (auto& system : m_systems)
+		if (m_component_factory->get_storage_mode() == ComponentFactory::StorageMode::Pools)
+			_update_matches();
+
+		std::size_t first = 0;
+		while (first < m_systems.size())
+		{
+			std::size_t last = first + 1;
+			while (last < m_systems.size() && m_stages[last] == m_stages[first])
+				++last;
+
+			if (m_job_pool == nullptr)
+			{
+				for (std::size_t system = first; system < last; ++system)
+					_run_system(*m_systems[system], 0);
+			}
+			else
+			{
+				_process_parallel(first, last);
+			}
+
+			_playback_commands();
+			first = last;
+		}
+
+		// Commands recorded with no system to run
+		if (m_systems.empty())
+			_playback_commands();
+	}
+
+	void SystemLooper::set_worker_count(std::size_t p_worker_count)
+	{
+		if (p_worker_count == 1)
+			m_job_pool.reset();
+		else
+			m_job_pool.reset(new JobPool(p_worker_count));
+
+		// Buffers of the removed workers are played back by the next process()
+		while (m_command_buffers.size() < get_worker_count())
+			m_command_buffers.emplace_back(new CommandBuffer());
+	}
+
+	void SystemLooper::_run_system(System& p_system, std::size_t p_worker)
+	{
+		p_system.m_worker_count = get_worker_count();
+		p_system.m_command_buffers = m_command_buffers.data();
+		p_system.m_worker = p_worker;
+
+		// Changes made from now on, by this system too, are seen by its next run
+		p_system.m_last_run_tick = p_system.m_run_tick;
+		p_system.m_run_tick = m_component_factory->advance_change_tick();
+		const Component::signature_t watched = p_system.m_has_run ? p_system.m_watched : Component::signature_t();
+		const std::uint32_t since = p_system.m_last_run_tick;
+		p_system.m_has_run = true;
+
+		p_system.preprocess();
+
+		if (p_system.get_chunk_size() != 0)
 		{
-			system->preprocess();
+			// Chunks run on any worker, the system's own buffer is off limits till finalize()
+			p_system.m_worker = System::no_worker;
+			_run_chunks(p_system, p_worker, watched);
+			p_system.m_worker = p_worker;
+			p_system.finalize();
+			return;
+		}
 
-			const auto& registered = system->get_registered_all();
+		const Component::signature_t& required = p_system.get_signature();
 
-			// Finding first registered component
-			Component::type_t first_type = Component::max_component_number + 1;
-			for (unsigned int i = 0; i < Component::max_component_number; ++i)
+		if (m_component_factory->get_storage_mode() == ComponentFactory::StorageMode::Archetypes)
+		{
+			// Every row of a matching table is a match, no need to check the entity
+			if (required.any())
 			{
-				if (system->is_component_registered(i))
+				m_component_factory->for_each_archetype(required, [&](Archetype& p_archetype)
 				{
-					first_type = i;
-					break;
-				}
-			}
+					for (std::size_t row = 0; row < p_archetype.get_size(); ++row)
+					{
+						Entity* entity = p_archetype.get_entity(row);
+						if (watched.any() && !_is_changed(*entity, watched, since))
+							continue;
 
-			if (first_type == Component::max_component_number + 1)
-				continue; // No components registered
+						EntityHandle handle(*entity, *m_entity_factory, *m_component_factory, p_worker);
+						p_system.process(handle);
+					}
+				});
+			}
 
-			// Getting bag of components
-			auto& first_bag = m_component_factory->get_components_all(first_type);
+			p_system.finalize();
+			return;
+		}
 
-			// ""Iterating"" 
-			uint8_t* data = first_bag.get_data_ptr();
-			for (unsigned int i = 0; i < first_bag.get_last_element_pos(); ++i)
+		// The cache is only updated at the beginning of process(), it is safe to change entities while iterating
+		for (const Entity::id_t id : p_system.get_matches())
+		{
+			// Entities changed by the systems that ran before are checked again
+			if (_is_pending(id))
 			{
-				Component* component{ reinterpret_cast<Component*>(data + i * first_bag.get_element_size()) };
-				if (component->get_entity() == nullptr) // Current spot is empty
+				if (!m_entity_factory->is_alive(id) || !_matches(m_entity_factory->get_entity(id), p_system))
 					continue;
+			}
+
+			Entity& entity = m_entity_factory->get_entity(id);
+			if (watched.any() && !_is_changed(entity, watched, since))
+				continue;
+
+			EntityHandle handle(entity, *m_entity_factory, *m_component_factory, p_worker);
+			p_system.process(handle);
+		}
+
+		p_system.finalize();
+	}
+
+	bool SystemLooper::_is_changed(Entity& p_entity, const Component::signature_t& p_watched, std::uint32_t p_tick)
+	{
+		for (std::size_t type = p_watched.find_first(); type < Component::signature_t::bit_count; type = p_watched.find_next(type + 1))
+		{
+			if (p_entity.get_component_ptr(type)->is_changed_since(p_tick))
+				return true;
+		}
+		return false;
+	}
+
+	bool SystemLooper::_is_changed(const Archetype& p_archetype, std::size_t p_first, std::size_t p_last, 
+		const Component::signature_t& p_watched, std::uint32_t p_tick)
+	{
+		for (std::size_t type = p_watched.find_first(); type < Component::signature_t::bit_count; type = p_watched.find_next(type + 1))
+		{
+			for (std::size_t row = p_first; row < p_last; ++row)
+			{
+				if (p_archetype.get_component(row, type)->is_changed_since(p_tick))
+					return true;
+			}
+		}
+		return false;
+	}
 
-				Entity* next_entity{ component->get_entity() };
+	void SystemLooper::_run_chunks(System& p_system, std::size_t p_worker, const Component::signature_t& p_watched)
+	{
+		const std::uint32_t since = p_system.m_last_run_tick;
+		const std::size_t chunk_size = p_system.get_chunk_size();
+		JobPool::counter_t pending(0);
 
-				bool valid{ true };
-				for (unsigned int c = 0; c < Component::max_component_number; ++c)
+		if (m_component_factory->get_storage_mode() == ComponentFactory::StorageMode::Archetypes)
+		{
+			// Tables are split in ranges of rows, the components of a range are already contiguous
+			const Component::signature_t& required = p_system.get_signature();
+			if (required.any())
+			{
+				System* system = &p_system;
+				m_component_factory->for_each_archetype(required, [&](Archetype& p_archetype)
 				{
-					if (registered[c] && !next_entity->has_component(c))
-						valid = false;
+					const std::size_t count = p_archetype.get_size();
+					if (p_watched.none() && (m_job_pool == nullptr || count <= chunk_size))
+					{
+						if (count != 0)
+							p_system.process_rows(p_archetype, 0, count, p_worker);
+						return;
+					}
+
+					Archetype* archetype = &p_archetype;
+					for (std::size_t first = 0; first < count; first += chunk_size)
+					{
+						const std::size_t last = std::min(first + chunk_size, count);
+						if (p_watched.any() && !_is_changed(p_archetype, first, last, p_watched, since))
+							continue;
+
+						if (m_job_pool == nullptr || count <= chunk_size)
+						{
+							p_system.process_rows(p_archetype, first, last, p_worker);
+							continue;
+						}
+
+						m_job_pool->push([system, archetype, first, last](std::size_t p_job_worker)
+						{
+							system->process_rows(*archetype, first, last, p_job_worker);
+						}, p_worker, &pending);
+					}
+				});
+			}
+
+			if (m_job_pool != nullptr)
+				m_job_pool->wait(pending, p_worker);
+			return;
+		}
+
+		// Matches are gathered up front, entities changed by the systems that ran before are filtered out here 
+		// so that the chunks never need the pending lock
+		auto& entities = p_system.m_range_entities;
+		entities.clear();
+		for (const Entity::id_t id : p_system.get_matches())
+		{
+			if (_is_pending(id) && (!m_entity_factory->is_alive(id) || !_matches(m_entity_factory->get_entity(id), p_system)))
+				continue;
+
+			Entity& entity = m_entity_factory->get_entity(id);
+			if (p_watched.any() && !_is_changed(entity, p_watched, since))
+				continue;
+			entities.push_back(&entity);
+		}
+
+		if (entities.empty())
+			return;
+
+		Entity* const* begin = entities.data();
+		const std::size_t count = entities.size();
+
+		if (m_job_pool == nullptr || count <= chunk_size)
+		{
+			p_system.process_range(begin, begin + count, p_worker);
+			return;
+		}
+
+		for (std::size_t first = 0; first < count; first += chunk_size)
+		{
+			const std::size_t last = std::min(first + chunk_size, count);
+			System* system = &p_system;
+			m_job_pool->push([system, begin, first, last](std::size_t p_job_worker)
+			{
+				system->process_range(begin + first, begin + last, p_job_worker);
+			}, p_worker, &pending);
+		}
+		m_job_pool->wait(pending, p_worker);
+	}
+
+	void SystemLooper::_process_parallel(std::size_t p_first, std::size_t p_last)
+	{
+		const std::size_t count = p_last - p_first;
+		m_first_node = p_first;
+
+		// Rebuilt every stage, declarations can change and the number of systems is small
+		if (m_graph.size() < count)
+		{
+			m_graph.resize(count);
+			m_remaining.reset(new std::atomic<std::uint32_t>[count]);
+		}
+
+		for (std::size_t node = 0; node < count; ++node)
+		{
+			m_graph[node].successors.clear();
+			m_graph[node].predecessors = 0;
+		}
+
+		for (std::size_t second = 0; second < count; ++second)
+		{
+			for (std::size_t first = 0; first < second; ++first)
+			{
+				if (_conflicts(p_first + first, p_first + second))
+				{
+					m_graph[first].successors.push_back(second);
+					++m_graph[second].predecessors;
 				}
+			}
+		}
+
+		for (std::size_t node = 0; node < count; ++node)
+			m_remaining[node].store(m_graph[node].predecessors);
+
+		for (std::size_t node = 0; node < count; ++node)
+		{
+			if (m_graph[node].predecessors == 0)
+				m_job_pool->push([this, node](std::size_t p_worker) { _run_node(node, p_worker); });
+		}
+
+		m_job_pool->wait_idle();
+	}
+
+	void SystemLooper::_run_node(std::size_t p_node, std::size_t p_worker)
+	{
+		_run_system(*m_systems[m_first_node + p_node], p_worker);
+
+		for (const std::size_t successor : m_graph[p_node].successors)
+		{
+			if (m_remaining[successor].fetch_sub(1) == 1)
+				m_job_pool->push([this, successor](std::size_t p_job_worker) { _run_node(successor, p_job_worker); }, p_worker);
+		}
+	}
 
-				if (valid)
-					system->process(EntityHandle(*next_entity, *m_component_factory));
+	void SystemLooper::_playback_commands()
+	{
+		bool changed = false;
+		for (auto& buffer : m_command_buffers)
+		{
+			if (!buffer->empty())
+			{
+				buffer->playback(*m_entity_factory, *m_component_factory);
+				changed = true;
 			}
+		}
+
+		// The next stage must see the new compositions
+		if (changed && m_component_factory->get_storage_mode() == ComponentFactory::StorageMode::Pools)
+			_update_matches();
+	}
+
+	bool SystemLooper::_conflicts(std::size_t p_first, std::size_t p_second)const
+	{
+		if (m_stages[p_first] != m_stages[p_second])
+			return true;
+
+		const System& first = *m_systems[p_first];
+		const System& second = *m_systems[p_second];
+		if (!first.has_declared_access() || !second.has_declared_access())
+			return true;
+
+		return first.get_write_signature().intersects(second.get_read_signature() | second.get_write_signature()) ||
+			second.get_write_signature().intersects(first.get_read_signature());
+	}
+
+	bool SystemLooper::_is_pending(Entity::id_t p_id)
+	{
+		// Nothing changed since the beginning of process(), common case
+		if (m_pending_count.load(std::memory_order_acquire) == 0)
+			return false;
+
+		std::lock_guard<std::mutex> lock(m_pending_mutex);
+		return p_id < m_pending_flags.size() && m_pending_flags[static_cast<std::size_t>(p_id)] != 0;
+	}
 
-			system->finalize();
+	void SystemLooper::invalidate_matches()
+	{
+		std::lock_guard<std::mutex> lock(m_pending_mutex);
+
+		for (auto system : m_systems)
+			system->m_matches_dirty = true;
+
+		m_pending.clear();
+		m_pending_flags.clear();
+		m_pending_count.store(0);
+	}
+
+	void SystemLooper::on_component_attached(Entity& p_entity, Component::type_t)
+	{
+		_mark_pending(p_entity);
+	}
+
+	void SystemLooper::on_component_detached(Entity& p_entity, Component::type_t)
+	{
+		_mark_pending(p_entity);
+	}
+
+	void SystemLooper::on_entity_removed(Entity& p_entity)
+	{
+		_mark_pending(p_entity);
+	}
+
+	void SystemLooper::_mark_pending(const Entity& p_entity)
+	{
+		// Tables already group entities by composition
+		if (m_component_factory->get_storage_mode() != ComponentFactory::StorageMode::Pools)
+			return;
+
+		std::lock_guard<std::mutex> lock(m_pending_mutex);
+
+		const std::size_t id = static_cast<std::size_t>(p_entity.id);
+		if (id >= m_pending_flags.size())
+			m_pending_flags.resize(id + 1, 0);
+
+		if (m_pending_flags[id] == 0)
+		{
+			m_pending_flags[id] = 1;
+			m_pending.push_back(p_entity.id);
+			m_pending_count.store(m_pending.size());
+		}
+	}
+
+	void SystemLooper::_update_matches()
+	{
+		std::lock_guard<std::mutex> lock(m_pending_mutex);
+
+		for (auto system : m_systems)
+		{
+			if (system->m_matches_dirty)
+				_rebuild_matches(*system);
 		}
+
+		for (auto id : m_pending)
+		{
+			const bool alive = m_entity_factory->is_alive(id);
+			for (auto system : m_systems)
+			{
+				const bool match = alive && system->get_signature().any() && _matches(m_entity_factory->get_entity(id), *system);
+				system->_set_match(id, match);
+			}
+
+			m_pending_flags[static_cast<std::size_t>(id)] = 0;
+		}
+		m_pending.clear();
+		m_pending_count.store(0);
+	}
+
+	void SystemLooper::_rebuild_matches(System& p_system)
+	{
+		p_system._clear_matches();
+		p_system.m_matches_dirty = false;
+
+		const Component::signature_t& required = p_system.get_signature();
+		if (required.none())
+			return;
+
+		// Every match has a component of each registered type, walking the smallest of their pools only
+		const Component::type_t driver_type = _select_driver(required);
+		p_system.m_driver_type = driver_type;
+		p_system.m_driver_size = m_component_factory->get_live_count(driver_type);
+
+		auto& driver_bag = m_component_factory->get_components_all(driver_type);
+		m_scratch_ids.clear();
+		m_scratch_signatures.clear();
+		driver_bag.for_each([&](Bag::index_t p_index)
+		{
+			const Entity* entity{ driver_bag.get_object<Component>(p_index).get_entity() };
+			m_scratch_ids.push_back(entity->id);
+			m_scratch_signatures.push_back(entity->get_signature());
+		});
+
+		m_scratch_matches.resize(m_scratch_signatures.size());
+		const std::size_t count = filter_signatures(m_scratch_signatures.data(), m_scratch_signatures.size(), required, m_scratch_matches.data());
+		for (std::size_t i = 0; i < count; ++i)
+			p_system._set_match(m_scratch_ids[static_cast<std::size_t>(m_scratch_matches[i])], true);
+	}
+
+	Component::type_t SystemLooper::_select_driver(const Component::signature_t& p_required)const
+	{
+		Component::type_t driver_type = p_required.find_first();
+		std::size_t driver_count = m_component_factory->get_live_count(driver_type);
+		for (std::size_t type = p_required.find_next(static_cast<std::size_t>(driver_type) + 1); 
+			type < Component::signature_t::bit_count && driver_count != 0; type = p_required.find_next(type + 1))
+		{
+			const std::size_t count = m_component_factory->get_live_count(type);
+			if (count < driver_count)
+			{
+				driver_type = type;
+				driver_count = count;
+			}
+		}
+		return driver_type;
+	}
+
+	bool SystemLooper::_matches(const Entity& p_entity, const System& p_system)const
+	{
+		return signature_matches(p_entity.get_signature(), p_system.get_signature());
 	}
 }
\ No newline at end of file
@@ -1041,19 +1041,14 @@ namespace ssa
 
 		m_device_context->RSSetViewports(1, &viewport);
 
-		std::vector<ID3D11RenderTargetView*> views;
+		// D3D11 can't bind more than D3D11_SIMULTANEOUS_RENDER_TARGET_COUNT targets, no need to go to the heap
+		assert(p_count <= D3D11_SIMULTANEOUS_RENDER_TARGET_COUNT);
+		ID3D11RenderTargetView* views[D3D11_SIMULTANEOUS_RENDER_TARGET_COUNT];
 		for (unsigned int i{ 0 }; i < p_count; ++i)
-			views.push_back(p_render_targets[0]->render_target_view);
+			views[i] = p_render_targets[0]->render_target_view;
 
-		std::vector<ID3D11DepthStencilView*> depth_views;
-		if (p_bind_depth)
-		{
-			for (unsigned int i{ 0 }; i < p_count; ++i)
-				depth_views.push_back(p_render_targets[0]->depth_stencil_view);
-		}
-
-		m_device_context->OMSetRenderTargets(p_count, &views[0],
-			p_bind_depth ? depth_views[0] : nullptr);
+		m_device_context->OMSetRenderTargets(static_cast<UINT>(p_count), views,
+			p_bind_depth ? p_render_targets[0]->depth_stencil_view : nullptr);
 
 		return true;
 	}
@@ -12,9 +12,11 @@
 
 namespace ssa
 {
-	RenderDevice::RenderDevice() :
+	RenderDevice::RenderDevice(Allocator& p_allocator) :
 		m_commander{},
-		m_resource_factory{ m_commander }
+		m_resource_factory{ m_commander, p_allocator },
+		m_render_target_depth{ 0 },
+		m_frame_arena{ 64 * 1024, false, p_allocator }
 	{
 
 	}
@@ -32,6 +34,18 @@ namespace ssa
 		return true;
 	}
 
+	pool_stats_list_t RenderDevice::get_pool_stats()const
+	{
+		pool_stats_list_t stats;
+		m_resource_factory.get_pool_stats(stats);
+		return stats;
+	}
+
+	void RenderDevice::dump_stats(std::ostream& p_stream)const
+	{
+		write_pool_stats(p_stream, get_pool_stats());
+	}
+
 	///////////////////////////////////////////////////////////////////////
 	/// CREATION
 	///////////////////////////////////////////////////////////////////////
@@ -243,51 +257,47 @@ namespace ssa
 	bool RenderDevice::push_target(Texture& p_render_target, bool p_bind_depth, bool p_stack)
 	{
 		// If we have no render targets bound we ignore the stack parameter
-		if (m_render_target_stack.empty())
+		if (m_render_target_depth == 0 || !p_stack)
 		{
-			m_render_target_stack.push_back(RenderTargetBlock());
-			m_render_target_stack.back().push_back(p_render_target);
-		}
-		else
-		{
-			if (p_stack)
-				m_render_target_stack.back().push_back(p_render_target);
-			else
-			{
+			// Reusing the block left by a previous pop if there is one
+			if (m_render_target_depth == m_render_target_stack.size())
 				m_render_target_stack.push_back(RenderTargetBlock());
-				m_render_target_stack.back().push_back(p_render_target);
-			}
-		}
+			else
+				m_render_target_stack[m_render_target_depth].clear();
 
-		// Stacking up render targets
-		std::vector<TextureInternal*> render_targets;
-		for (auto& render_target : m_render_target_stack.back())
-		{
-			render_targets.push_back(&m_resource_factory.get_texture(render_target.get().get_id()));
+			++m_render_target_depth;
 		}
 
-		return m_commander.bind_targets(&render_targets[0], render_targets.size(), p_bind_depth);
+		get_rt_top().push_back(p_render_target);
+
+		return _bind_top_targets(p_bind_depth);
 	}
 
 	bool RenderDevice::pop_targets()
 	{
-		if (m_render_target_stack.empty())
+		if (m_render_target_depth == 0)
 			return false;
 
-		m_render_target_stack.pop_back();
+		--m_render_target_depth;
 
-		if (m_render_target_stack.empty())
+		if (m_render_target_depth == 0)
 			return true;
 
-		// Stacking up render targets
-		std::vector<TextureInternal*> render_targets;
-		for (auto& render_target : m_render_target_stack.back())
-		{
-			render_targets.push_back(&m_resource_factory.get_texture(render_target.get().get_id()));
-		}
+		return _bind_top_targets(false);
+	}
+
+	bool RenderDevice::_bind_top_targets(bool p_bind_depth)
+	{
+		const RenderTargetBlock& block = get_rt_top();
 
-		return m_commander.bind_targets(&render_targets[0], render_targets.size(), false);
+		// Stacking up render targets, the list only lives till the end of the frame
+		const ArenaAllocator<TextureInternal*> allocator(m_frame_arena);
+		std::vector<TextureInternal*, ArenaAllocator<TextureInternal*>> render_targets(allocator);
+		render_targets.reserve(block.size());
+		for (auto& render_target : block)
+			render_targets.push_back(&m_resource_factory.get_texture(render_target.get().get_id()));
 
+		return m_commander.bind_targets(&render_targets[0], render_targets.size(), p_bind_depth);
 	}
 
 	bool RenderDevice::bind_blender(const Blender& p_blender)
@@ -363,6 +373,9 @@ namespace ssa
 	{
 		const auto& render_window_internal = m_resource_factory.get_texture(p_render_window.get_id());
 
+		// Nothing allocated during the frame is used after the swap
+		m_frame_arena.reset();
+
 		return m_commander.finalize(render_window_internal, p_vsync);
 	}
 }
\ No newline at end of file
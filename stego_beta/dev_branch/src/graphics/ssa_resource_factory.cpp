@@ -7,13 +7,13 @@
 
 namespace ssa
 {
-	ResourceFactory::ResourceFactory(Commander& p_commander) :
+	ResourceFactory::ResourceFactory(Commander& p_commander, Allocator& p_allocator) :
 		m_commander{ p_commander },
-		m_textures{ 10 },
-		m_buffers{ 50 },
-		m_shaders{ 10 },
-		m_samplers{ 10 },
-		m_blenders{ 10 }
+		m_textures{ 10, p_allocator },
+		m_buffers{ 50, p_allocator },
+		m_shaders{ 10, p_allocator },
+		m_samplers{ 10, p_allocator },
+		m_blenders{ 10, p_allocator }
 	{
 
 	}
@@ -23,6 +23,15 @@ namespace ssa
 
 	}
 
+	void ResourceFactory::get_pool_stats(pool_stats_list_t& p_stats)const
+	{
+		p_stats.push_back(std::make_pair(std::string("textures"), m_textures.get_stats()));
+		p_stats.push_back(std::make_pair(std::string("buffers"), m_buffers.get_stats()));
+		p_stats.push_back(std::make_pair(std::string("shaders"), m_shaders.get_stats()));
+		p_stats.push_back(std::make_pair(std::string("samplers"), m_samplers.get_stats()));
+		p_stats.push_back(std::make_pair(std::string("blenders"), m_blenders.get_stats()));
+	}
+
 	ResourceBatch<TextureInternal>::index_t ResourceFactory::create_texture()
 	{
 		return m_textures.create_resource();